@@ -46,7 +46,21 @@ SOURCES += src/harbour-london-sail.cpp \
     src/logic/maps/mapsmodel.cpp \
     src/logic/maps/busmap.cpp \
     src/logic/maps/busmapdownloader.cpp \
-    src/logic/maps/mapfilesmodel.cpp
+    src/logic/maps/mapfilesmodel.cpp \
+    src/logic/arrivals/multistoparrivals.cpp \
+    src/logic/arrivals/pollscheduler.cpp \
+    src/logic/arrivals/urareader.cpp \
+    src/logic/arrivals/urarecords.cpp \
+    src/logic/arrivals/urastream.cpp \
+    src/logic/network/managedreply.cpp \
+    src/logic/network/requestmanager.cpp \
+    src/logic/database/stopindex.cpp \
+    src/logic/database/stopnameindex.cpp \
+    src/logic/database/stopimporter.cpp \
+    src/logic/database/databaseexecutor.cpp \
+    src/logic/database/readerpool.cpp \
+    src/logic/database/statementcache.cpp \
+    src/logic/database/stoprecord.cpp
 
 OTHER_FILES += qml/harbour-london-sail.qml \
     qml/cover/CoverPage.qml \
@@ -78,6 +92,7 @@ OTHER_FILES += qml/harbour-london-sail.qml \
     qml/cover/ArrivalsCover.qml \
     qml/pages/JourneyProgressPage.qml \
     qml/cover/JourneyProgressCover.qml \
+    qml/cover/FavoritesCover.qml \
     qml/gui/StopIcon.qml \
     qml/gui/RunningText.qml \
     qml/pages/MapsPage.qml \
@@ -119,7 +134,21 @@ HEADERS += \
     src/logic/maps/mapsmodel.h \
     src/logic/maps/busmap.h \
     src/logic/maps/busmapdownloader.h \
-    src/logic/maps/mapfilesmodel.h
+    src/logic/maps/mapfilesmodel.h \
+    src/logic/arrivals/multistoparrivals.h \
+    src/logic/arrivals/pollscheduler.h \
+    src/logic/arrivals/urareader.h \
+    src/logic/arrivals/urarecords.h \
+    src/logic/arrivals/urastream.h \
+    src/logic/network/managedreply.h \
+    src/logic/network/requestmanager.h \
+    src/logic/database/stopindex.h \
+    src/logic/database/stopnameindex.h \
+    src/logic/database/stopimporter.h \
+    src/logic/database/databaseexecutor.h \
+    src/logic/database/readerpool.h \
+    src/logic/database/statementcache.h \
+    src/logic/database/stoprecord.h
 
 RESOURCES += \
     images.qrc
@@ -30,7 +30,20 @@ import "../gui"
 //This is displayed while tracking arrivals/deparures of a stop
 Item {
     property bool active: false
-    property ArrivalsModel arrivalsModel: arrivalsData.getArrivalsModel()
+    property ArrivalsModel arrivalsModel: null
+    //code of the stop page on top, the cover holds a subscription of its own so it keeps updating on the cover
+    property string stopCode: ""
+    property string subscribedCode: ""
+    onStopCodeChanged: {
+        var previous = subscribedCode
+        subscribedCode = stopCode
+        arrivalsModel = stopCode !== "" ? arrivalsData.subscribeStop(stopCode) : null
+        //subscribed first so that polling does not stop and start again in between
+        if (previous !== "") { arrivalsData.unsubscribeStop(previous) }
+    }
+    Component.onDestruction: {
+        if (subscribedCode !== "") { arrivalsData.unsubscribeStop(subscribedCode) }
+    }
 
     ListView {
         id: view
@@ -35,6 +35,7 @@ import harbour.london.sail.utilities 1.0
 //main cover page
 CoverBackground {
     property bool active: status === Cover.Active
+    onActiveChanged: coverData.reportCoverStatus(active)
     property int currentPage: PageCodes.None
     anchors.fill: parent
     Image {
@@ -50,7 +51,7 @@ CoverBackground {
         CoverAction {
             id: busPageAction
             iconSource: "image://theme/icon-cover-refresh"
-            onTriggered: arrivalsData.startArrivalsUpdate()
+            onTriggered: arrivalsData.refreshArrivals()
         }
     }
 
@@ -69,19 +70,25 @@ CoverBackground {
             currentPage = coverData.getCurrentPage()
             switch (currentPage) {
             case PageCodes.BusStopPage:
+                arrivalsCover.stopCode = pageStack.currentPage.stopID
                 placeholder.visible = false
                 arrivalsCover.visible = true
                 journeyProgressCover.visible = false
+                favoritesCover.visible = false
                 break;
             case PageCodes.JourneyProgressPage:
+                arrivalsCover.stopCode = ""
                 placeholder.visible = false
                 journeyProgressCover.visible = true
                 arrivalsCover.visible = false
+                favoritesCover.visible = false
                 break;
             case PageCodes.None:
+                arrivalsCover.stopCode = ""
                 placeholder.visible = true
                 arrivalsCover.visible = false
                 journeyProgressCover.visible = false
+                favoritesCover.visible = true
             }
         }
     }
@@ -109,6 +116,16 @@ CoverBackground {
         }
         height: parent.height * 0.7
     }
+    //favorites only have data while DeparturePage is the current page
+    FavoritesCover {
+        id: favoritesCover
+        anchors {
+            top: placeholder.bottom
+            left: parent.left
+            right: parent.right
+        }
+        height: parent.height * 0.6
+    }
     JourneyProgressCover {
         id: journeyProgressCover
         anchors {
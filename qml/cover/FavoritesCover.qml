@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+import QtQuick 2.0
+import Sailfish.Silica 1.0
+
+//This is displayed while the favorite stops are listed, it shows the next vehicle of each of them
+Item {
+    ListView {
+        id: view
+        anchors {
+            top: parent.top
+            topMargin: Theme.paddingMedium
+            bottom: parent.bottom
+            left: parent.left
+            leftMargin: 40
+            right: parent.right
+            rightMargin: 40
+        }
+        model: arrivalsData.getStopsQueryModel()
+        interactive: false
+        delegate: Item {
+            id: favorite
+            property int nextEta: -1
+            property string nextLine: ""
+            anchors {
+                left: parent.left
+                right: parent.right
+            }
+            //stops without a vehicle or not being favorites take no space
+            visible: nextEta >= 0
+            height: visible ? lineLabel.paintedHeight : 0
+
+            function update() {
+                nextEta = rankData > 0 ? arrivalsData.getFavoriteNextEta(codeData) : -1
+                nextLine = rankData > 0 ? arrivalsData.getFavoriteNextLine(codeData) : ""
+            }
+            Component.onCompleted: update()
+
+            //favorites are updated together with a single request while they are listed
+            Connections {
+                target: arrivalsData
+                onFavoriteArrivalsChanged: favorite.update()
+            }
+
+            Label {
+                id: indicatorLabel
+                text: stopPointIndicatorData
+                font.pixelSize: Theme.fontSizeSmall
+                color: Theme.secondaryColor
+                anchors {
+                    left: parent.left
+                    baseline: lineLabel.baseline
+                }
+            }
+            Label {
+                id: lineLabel
+                text: nextLine
+                color: Theme.highlightColor
+                anchors {
+                    left: indicatorLabel.right
+                    leftMargin: indicatorLabel.text !== "" ? Theme.paddingSmall : 0
+                }
+            }
+            Label {
+                id: etaLabel
+                text: nextEta < 2 ? "due" : nextEta + "min"
+                horizontalAlignment: Text.AlignRight
+                anchors.right: parent.right
+            }
+        }
+    }
+}
@@ -32,6 +32,7 @@ BackgroundItem {
     property alias destination: destinationLabel.text
     property string busId: ""
     property int eta: 9999
+    property bool stale: false //saved prediction, shown until the first download
 
     anchors {
         left: parent.left
@@ -63,6 +64,7 @@ BackgroundItem {
     Label {
         id: etaLabel
         text: (eta < 2) ? "due" : eta + "min"
+        color: stale ? Theme.secondaryColor : Theme.primaryColor
         anchors {
             right: parent.right
             verticalCenter: parent.verticalCenter
@@ -31,12 +31,13 @@ Item {
     property color backgroundColor: Theme.highlightColor
     property double backgroundOpacity: 0.4
     property color textColor: Theme.highlightDimmerColor
+    property Stop stop
 
     state: (messageLabel.text === "") ? "invisible" : "visible"
     Connections {
-        target: arrivalsData
-        onCurrentStopMessagesChanged: {
-            messageLabel.text = arrivalsData.getCurrentStopMessages()
+        target: self.stop
+        onDataChanged: {
+            messageLabel.text = self.stop.getMessages()
         }
     }
 
@@ -53,7 +54,7 @@ Item {
             id: messageLabel
             color: textColor
             clip: true
-            text: arrivalsData.getCurrentStopMessages()
+            text: self.stop ? self.stop.getMessages() : ""
             anchors.verticalCenter: parent.verticalCenter
 
 //            Component.onCompleted: {
@@ -63,7 +64,7 @@ Item {
 
             onTextChanged: {
                 state = (messageLabel.text === "") ? "invisible" : "visible"
-                arrivalsData.refreshArrivalsModel()
+                if (self.stop) { arrivalsData.refreshArrivalsModel(self.stop.getID()) }
             }
         }
         NumberAnimation {
@@ -28,14 +28,14 @@ import harbour.london.sail.utilities 1.0
 
 Item {
     id: self
-    property Stop currentStop: arrivalsData.getCurrentStop()
-    property string stopPointIndicator: currentStop.getStopPointIndicator()
-    property string direction: currentStop.getTowards()
+    property Stop currentStop
+    property string stopPointIndicator: currentStop ? currentStop.getStopPointIndicator() : ""
+    property string direction: currentStop ? currentStop.getTowards() : ""
     property alias distance: distanceLabel.text
     property string message: ""
-    property string stopCode: currentStop.getID()
-    property int type: currentStop.getType()
-    property string title: currentStop.getName()
+    property string stopCode: currentStop ? currentStop.getID() : ""
+    property int type: currentStop ? currentStop.getType() : Stop.None
+    property string title: currentStop ? currentStop.getName() : ""
     property bool isFavorite: arrivalsData.isStopFavorite(stopCode)
     property double headerOpacity: Theme.highlightBackgroundOpacity
 
@@ -52,6 +52,11 @@ Item {
 
         }
     }
+    //favorites are written in the background
+    Connections {
+        target: arrivalsData
+        onFavoritesChanged: self.isFavorite = arrivalsData.isStopFavorite(stopCode)
+    }
 
     anchors {
         left: parent.left
@@ -77,6 +82,7 @@ Item {
     }
     RunningText {
         id: messageBox
+        stop: self.currentStop
         anchors {
             top: pageHeader.bottom
             topMargin: Theme.paddingMedium*2
@@ -117,11 +123,9 @@ Item {
             if (!isFavorite) {
                 self.currentStop.addToDb(true)//won't do anything if record is already in db
                 arrivalsData.favorStop(stopCode, true)//make sure it is favorite in case record was already in db
-                isFavorite = arrivalsData.isStopFavorite(stopCode)
             }
             else {
                 arrivalsData.favorStop(stopCode, false)
-                isFavorite = arrivalsData.isStopFavorite(stopCode)
             }
         }
     }
@@ -140,7 +144,7 @@ Item {
 
     Label {
         id: directionLabel
-        text: currentStop.getTowards()
+        text: self.direction
         color: Theme.highlightColor
         wrapMode: Text.WordWrap
         anchors {
@@ -178,6 +182,8 @@ Item {
         minimumValue: 0
         maximumValue: 100
         value: 0
+        //display timer ticks once a second
+        Behavior on value { NumberAnimation { duration: 1000 } }
     }
     Connections {
         target: arrivalsData
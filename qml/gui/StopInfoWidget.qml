@@ -36,6 +36,8 @@ Rectangle {
     property string rank: ""
     property bool isFavorite: arrivalsData.isStopFavorite(code)
     property bool isDragable: false
+    property int nextEta: -1
+    property string nextLine: ""
 
     id: self
     height: nameLabel.paintedHeight + towardLabel.paintedHeight + Theme.paddingMedium * 2
@@ -43,6 +45,17 @@ Rectangle {
     color: isDragable ? Theme.highlightBackgroundColor : Theme.secondaryHighlightColor
     Behavior on color { ColorAnimation { duration: 100 } }
 
+    //live eta of the first vehicle, favorites are updated together with a single request
+    Connections {
+        target: arrivalsData
+        onFavoriteArrivalsChanged: {
+            self.nextEta = self.isFavorite ? arrivalsData.getFavoriteNextEta(code) : -1
+            self.nextLine = self.isFavorite ? arrivalsData.getFavoriteNextLine(code) : ""
+        }
+        //favorites are written in the background
+        onFavoritesChanged: self.isFavorite = arrivalsData.isStopFavorite(code)
+    }
+
     StopIcon {
         id: icon
         stopPointIndicator: indicator
@@ -95,6 +108,18 @@ Rectangle {
             leftMargin: 10
         }
     }
+    Label {
+        id: etaLabel
+        text: (nextEta < 0) ? "" : (nextEta < 2) ? nextLine + " due" : nextLine + " " + nextEta + "min"
+        font.pixelSize: Theme.fontSizeExtraSmall
+        color: Theme.highlightColor
+        anchors {
+            bottom: parent.bottom
+            bottomMargin: Theme.paddingSmall
+            right: parent.right
+            rightMargin: Theme.paddingMedium
+        }
+    }
     IconButton {
         id: iconButton
         icon.source: isFavorite ? "image://theme/icon-l-favorite" : "image://theme/icon-l-star"
@@ -109,7 +134,6 @@ Rectangle {
             else {
                 arrivalsData.favorStop(code, true)
             }
-            isFavorite = arrivalsData.isStopFavorite(code)
         }
     }
 }
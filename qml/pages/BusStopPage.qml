@@ -60,7 +60,7 @@ Page {
 
     SilicaListView {
         id: view
-        property Stop currentStop: arrivalsData.getCurrentStop()
+        property Stop currentStop: null
         property string busStopName: ""
         property string stopIndicator: ""
         property string stopCode: ""
@@ -69,7 +69,7 @@ Page {
         property bool isLoading: true
         property int type: 0
 
-        property ArrivalsModel arrivalsModel: arrivalsData.getArrivalsModel()
+        property ArrivalsModel arrivalsModel: null
 
         PullDownMenu {
             id: pulley
@@ -77,7 +77,7 @@ Page {
                 id: refreshMenuItem
                 text: "Refresh"
                 onClicked: {
-                    arrivalsData.startArrivalsUpdate()
+                    arrivalsData.refreshArrivals()
                 }
             }
         }
@@ -92,10 +92,7 @@ Page {
                     view.direction = view.currentStop.getTowards()
                     view.type = view.currentStop.getType()
                     view.stopCode = view.currentStop.getID()
-                    arrivalsData.refreshArrivalsModel()
-
-                    //only start updating if header data is already available
-                    arrivalsData.startArrivalsUpdate()
+                    arrivalsData.refreshArrivalsModel(view.stopCode)
                 }
             }
         }
@@ -115,6 +112,7 @@ Page {
             busNumber: lineData
             destination: destinationData
             eta: etaData
+            stale: staleData
             busId:  idData
             ListView.onAdd: AddAnimation {
                 target: busWidget
@@ -129,13 +127,14 @@ Page {
         onCountChanged: {
             if (footerItem) { footerItem.state = count ? "visible" : "invisible" }
         }
+        //every page has a stop and a subscription of its own, opening another stop leaves this one updating
         Component.onCompleted: {
-            arrivalsData.getBusStopByCode(page.stopID)
-            arrivalsData.getBusStopMessage(page.stopID)
+            view.currentStop = arrivalsData.openStop(page.stopID)
+            view.arrivalsModel = arrivalsData.subscribeStop(page.stopID)
         }
         Component.onDestruction: {
-            arrivalsData.stopArrivalsUpdate()
-            arrivalsData.clearCurrentStop()
+            arrivalsData.unsubscribeStop(page.stopID)
+            arrivalsData.closeStop(view.currentStop)
             coverData.reportPage(PageCodes.None)
             arrivalsData.setStopsQueryModel(Stop.Bus)
         }
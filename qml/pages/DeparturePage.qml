@@ -36,15 +36,18 @@ Page {
     property string codeBeingDragged: ""
     property string codeSwappedFor: ""
     property int currentDragIndex
-    property int currentDelegateIndex
+    property int dragStartIndex//where the favorite being dragged was picked up
     property StopsModel stopsModel: arrivalsData.getStopsQueryModel()
     allowedOrientations: Orientation.All
     onStatusChanged: {
-                if (status === PageStatus.Active) { coverData.reportPage(PageCodes.None) }
+                if (status === PageStatus.Active) {
+                    coverData.reportPage(PageCodes.None)
+                    arrivalsData.startFavoriteArrivalsUpdate()
+                }
+                else if (status === PageStatus.Deactivating) { arrivalsData.stopFavoriteArrivalsUpdate() }
     }
 
     function readInput(input) {
-        stopsModel.clearStops()
         var re = /^\d+$/
         if (re.test(input)) {
             pageStack.push(Qt.resolvedUrl("BusStopPage.qml"), {'stopID': input } )
@@ -120,15 +123,15 @@ Page {
 //                    hapticsEffect.start()
                     codeBeingDragged = infoWidget.code
                     console.log("dragging " + infoWidget.name + " " + codeBeingDragged)
-                    page.currentDelegateIndex = dragArea.VisualDataModel.itemsIndex
+                    page.dragStartIndex = dragArea.VisualDataModel.itemsIndex
                 }
             }
             onReleased: {
+                //rows only move in the model while dragging, the new place is saved once it is dropped
+                if (held) { stopsModel.saveMove(page.dragStartIndex, dragArea.VisualDataModel.itemsIndex) }
                 held = false
                 page.backNavigation = true
                 page.forwardNavigation = true
-
-                stopsModel.move(page.currentDelegateIndex,page.currentDragIndex)
             }
             onClicked: {
                 //trying to open with an empty string would cause application to terminate
@@ -189,7 +192,7 @@ Page {
                 onEntered: {
                     if (infoWidget.isFavorite) {
                         page.currentDragIndex = dragArea.VisualDataModel.itemsIndex
-                        visualModel.items.move(
+                        stopsModel.move(
                                 drag.source.VisualDataModel.itemsIndex,
                                 dragArea.VisualDataModel.itemsIndex)
                     }
@@ -212,6 +215,8 @@ Page {
             title: "Bus Departures"
             placeholderText: "Code/Stop Name"
             onEnterClicked: readInput(text)
+            //stops already in db are matched as the user types
+            onTextChanged: stopsModel.search(text)
             state: "visible"
         }
 
@@ -240,6 +245,7 @@ Page {
     }
 
     Component.onDestruction: {
-        stopsModel.clearStops()
+        arrivalsData.stopFavoriteArrivalsUpdate()
+        stopsModel.clearSearch()
     }
 }
@@ -146,6 +146,8 @@ Page {
                 minimumValue: 0
                 maximumValue: 100
                 value: 0
+                //display timer ticks once a second
+                Behavior on value { NumberAnimation { duration: 1000 } }
 
                 anchors {
                     left: parent.left
@@ -228,13 +230,12 @@ Page {
 
     }
 
+    //arrivals of the stop underneath are kept, they are polled less often while hidden
     Component.onCompleted: {
-        arrivalsData.stopArrivalsUpdate()
         arrivalsData.startJourneyProgressUpdate()
     }
 
     Component.onDestruction: {
         arrivalsData.stopJourneyProgressUpdate()
-        arrivalsData.startArrivalsUpdate()
     }
 }
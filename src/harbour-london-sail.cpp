@@ -72,6 +72,7 @@ THE SOFTWARE.
 #include "logic/maplogic.h"
 #include "logic/maps/mapfilesmodel.h"
 #include "logic/maps/mapsmodel.h"
+#include "logic/network/requestmanager.h"
 #include "logic/servicestatuslogic.h"
 #include "logic/serviceStatus/servicestatusproxymodel.h"
 #include "logic/serviceStatus/thisweekendlinemodel.h"
@@ -92,37 +93,40 @@ int main(int argc, char *argv[])
     view->setSource(SailfishApp::pathTo("qml/harbour-london-sail.qml"));
 
     //use 1 global QNetworkAccessManager object for all our network needs
-    //on the heap so that it can be the parent of serviceLogic
+    //on the heap so that it can be the parent of requestManager
     QScopedPointer<QNetworkAccessManager> networkMngr(new QNetworkAccessManager());
+    //every request goes through requestManager, it is the parent of the logic objects
+    RequestManager* requestManager = new RequestManager(networkMngr.data());
     QScopedPointer<DatabaseManager> databaseManager(new DatabaseManager());
 
     qmlRegisterType<ServiceStatusProxyModel>("harbour.london.sail.utilities",1,0, "ServiceStatusModel");
-    ServiceStatusLogic* serviceLogic = new ServiceStatusLogic(networkMngr.data());
+    ServiceStatusLogic* serviceLogic = new ServiceStatusLogic(requestManager);
     view->rootContext()->setContextProperty("serviceStatusData", serviceLogic);
 
     qmlRegisterType<ThisWeekendLineModel>("harbour.london.sail.utilities",1,0,"WeekendModel");
-    ThisWeekendLogic* weekendLogic = new ThisWeekendLogic(networkMngr.data());
+    ThisWeekendLogic* weekendLogic = new ThisWeekendLogic(requestManager);
     view->rootContext()->setContextProperty("thisWeekendData", weekendLogic);
 
     qmlRegisterType<DisruptionProxyModel>("harbour.london.sail.utilities",1,0,"DisruptionModel");
     qmlRegisterType<StreetModel>("harbour.london.sail.utilities",1,0,"StreetModel");
-    TrafficLogic* trafficLogic = new TrafficLogic(networkMngr.data());
+    TrafficLogic* trafficLogic = new TrafficLogic(requestManager);
     view->rootContext()->setContextProperty("trafficData", trafficLogic);
 
     qmlRegisterType<ArrivalsProxyModel>("harbour.london.sail.utilities",1,0,"ArrivalsModel");
     qmlRegisterType<StopsQueryModel>("harbour.london.sail.utilities",1,0,"StopsModel");
     qmlRegisterType<Stop>("harbour.london.sail.utilities",1,0,"Stop");
-    ArrivalsLogic* arrivalsLogic = new ArrivalsLogic(databaseManager.data(),networkMngr.data());
+    ArrivalsLogic* arrivalsLogic = new ArrivalsLogic(databaseManager.data(),requestManager);
     view->rootContext()->setContextProperty("arrivalsData", arrivalsLogic);
 
     qmlRegisterType<CoverLogic>("harbour.london.sail.utilities",1,0,"PageCodes");
     CoverLogic* coverLogic = new CoverLogic();
     view->rootContext()->setContextProperty("coverData", coverLogic);
+    arrivalsLogic->setCoverLogic(coverLogic);
 
     qmlRegisterType<MapFilesModel>("harbour.london.sail.utilities",1,0,"FilesModel");
 
     qmlRegisterType<MapsModel>("harbour.london.sail.utilities",1,0,"MapsModel");
-    MapLogic* mapLogic = new MapLogic(networkMngr.data());
+    MapLogic* mapLogic = new MapLogic(requestManager);
     view->rootContext()->setContextProperty("mapData", mapLogic);
 
     view->show();
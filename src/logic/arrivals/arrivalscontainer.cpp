@@ -23,14 +23,38 @@ THE SOFTWARE.
 */
 
 #include "arrivalscontainer.h"
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
 #include <QString>
 #include "arrivalsmodel.h"
 
-ArrivalsContainer::ArrivalsContainer(ArrivalsModel* m) : model(m)
+ArrivalsContainer::ArrivalsContainer(ArrivalsModel* m) : model(m),
+                                                          stale(false)
 {
 }
 
+//private:
+//removes the vehicles with the given keys, from the back so that rows are still valid,
+//neighbouring rows are removed together
+void ArrivalsContainer::removeKeys(const QSet<QString>& keys) {
+    if (keys.isEmpty()) return;
+    int row = size() - 1;
+    while (row >= 0) {
+        if (!keys.contains(at(row).getKey())) {
+            --row;
+            continue;
+        }
+        int last = row;
+        while (row > 0 && keys.contains(at(row - 1).getKey())) { --row; }
+        if (model) { model->beginRemove(row, last); }
+        erase(begin() + row, begin() + last + 1);
+        if (model) { model->endRemove(); }
+        --row;
+    }
+}
 
+//public:
 //adds a new vehicle, it shouldn't be called on containers whose models are connected to views
 void ArrivalsContainer::add(const Vehicle& vehicle) {
     append(vehicle);
@@ -38,6 +62,8 @@ void ArrivalsContainer::add(const Vehicle& vehicle) {
 
 //clears data and notifies model about it
 void ArrivalsContainer::clearData() {
+    stale = false;
+    if (isEmpty()) return;
     if (model) {
         model->beginRemove();
     }
@@ -47,23 +73,119 @@ void ArrivalsContainer::clearData() {
     }
 }
 
+//returns the seconds until the first vehicle arrives or -1 if there is none
+double ArrivalsContainer::getSecondsToNext() const {
+    double seconds = -1;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const_iterator iter = begin(); iter != end(); ++iter) {
+        double toArrival = (iter->estimatedTime - (now + iter->clockOffset)) / 1000;
+        if (toArrival >= 0 && (seconds < 0 || toArrival < seconds)) { seconds = toArrival; }
+    }
+    return seconds;
+}
+
+bool ArrivalsContainer::isStale() const { return stale; }
+
+//works out every eta again with the current time, so that etas count down between downloads
+//only vehicles whose eta changed are reported to the model, returns true if there was any
+bool ArrivalsContainer::refreshEtas() {
+    bool changed = false;
+    for (int index = 0; index != size(); ++index) {
+        if ((*this)[index].updateEta()) {
+            changed = true;
+            if (model) { model->notifyChanged(index); }
+        }
+    }
+    return changed;
+}
+
+//updates vehicles that are present in rhs and appends the new ones, nothing is removed
+//it is used for partial updates ie: predictions pushed by the stream
+//returns the average change of predictions in sec of vehicles present in both or -1 if there is none,
+//saved predictions are not compared as they might be from a long time ago
+double ArrivalsContainer::merge(const ArrivalsContainer& rhs) {
+    if (this == &rhs) return -1;
+    bool wasStale = stale;
+    setStale(false);
+    QHash<QString,int> rows;//key -> index in this
+    for (int index = 0; index != size(); ++index) {
+        rows.insert(at(index).getKey(), index);
+    }
+    double change = 0;
+    int updated = 0;
+    QList<Vehicle> added;
+    for (const_iterator iter = rhs.begin(); iter != rhs.end(); ++iter) {
+        QHash<QString,int>::const_iterator row = rows.find(iter->getKey());
+        if (row == rows.end()) {
+            rows.insert(iter->getKey(), size() + added.size());
+            added << *iter;
+            continue;
+        }
+        //a key that is new but came more than once, the latest one is kept
+        if (*row >= size()) {
+            added[*row - size()] = *iter;
+            continue;
+        }
+        Vehicle& current = (*this)[*row];
+        change += qAbs(iter->estimatedTime - current.estimatedTime) / 1000;
+        ++updated;
+        bool changed = current != *iter || current.eta != iter->eta;
+        current = *iter;//clock offset is always taken from the latest download
+        if (changed && model) { model->notifyChanged(*row); }
+    }
+    //append the ones that are new
+    if (!added.isEmpty()) {
+        if (model) { model->beginInsert(size(), size() + added.size() - 1); }
+        append(added);
+        if (model) { model->endInsert(); }
+    }
+    return updated && !wasStale ? change / updated : -1;
+}
+
 //when a model is created a model can register itself with a container
 //so that they both have a pointer of each other and can call each other's methods
 void ArrivalsContainer::registerModel(ArrivalsModel* m) {
     model = m;
 }
 
-//swaps another contaier for this and notifies model that a drastic change happened
-//swap so that even when a download goes awry there is data to display to user
-void ArrivalsContainer::replace(const ArrivalsContainer& rhs) {
-    if (model) {
-        clearData();
-        model->beginInsert(rhs.size() - 1);
+//removes vehicles whose predicted arrival is more than grace msec in the past,
+//the stream only pushes predictions so vehicles that have left are never removed by it
+//returns true if any vehicle was removed
+bool ArrivalsContainer::removeDeparted(double grace) {
+    QSet<QString> departed;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const_iterator iter = begin(); iter != end(); ++iter) {
+        if (iter->estimatedTime + grace < now + iter->clockOffset) { departed.insert(iter->getKey()); }
     }
+    removeKeys(departed);
+    return !departed.isEmpty();
+}
 
-    if (this != &rhs) { *this = rhs; }
+//updates this container to hold the same vehicles as rhs, vehicles are matched by Vehicle::getKey()
+//only vehicles that left are removed, only new ones are inserted and only changed ones are reported,
+//so views keep their delegates and scroll position, order is irrelevant as the proxy model sorts by eta
+//returns the average change of predictions in sec of vehicles present in both or -1 if there is none
+double ArrivalsContainer::replace(const ArrivalsContainer& rhs) {
+    if (this == &rhs) return -1;
+    QSet<QString> incoming;
+    for (const_iterator iter = rhs.begin(); iter != rhs.end(); ++iter) {
+        incoming.insert(iter->getKey());
+    }
+    QSet<QString> leaving;
+    for (const_iterator iter = begin(); iter != end(); ++iter) {
+        if (!incoming.contains(iter->getKey())) { leaving.insert(iter->getKey()); }
+    }
+    removeKeys(leaving);
+    return merge(rhs);
+}
 
-    if (model) {
-        model->endInsert();
+//marks data as saved predictions or as downloaded ones, every row is reported to the model
+//as views show saved predictions differently
+void ArrivalsContainer::setStale(bool b) {
+    if (stale == b) return;
+    stale = b;
+    if (!model) return;
+    for (int row = 0; row != size(); ++row) {
+        model->notifyChanged(row);
     }
 }
@@ -26,6 +26,7 @@ THE SOFTWARE.
 #define ARRIVALSCONTAINER_H
 
 #include <QList>
+#include <QSet>
 #include "vehicle.h"
 
 class QString;
@@ -38,11 +39,20 @@ public:
     ArrivalsContainer(ArrivalsModel* = 0);
 private:
     ArrivalsModel* model;
+    bool stale;//holds saved predictions that haven't been confirmed by a download
+private:
+    void removeKeys(const QSet<QString>& keys);
 public:
     void add(const Vehicle& vehicle);
     void clearData();
+    double getSecondsToNext() const;
+    bool isStale() const;
+    double merge(const ArrivalsContainer& rhs);
+    bool refreshEtas();
     void registerModel(ArrivalsModel*);
-    void replace(const ArrivalsContainer& rhs);
+    bool removeDeparted(double grace);
+    double replace(const ArrivalsContainer& rhs);
+    void setStale(bool);
 
 };
 
@@ -34,12 +34,15 @@ ArrivalsModel::ArrivalsModel(ArrivalsContainer* c, QObject *parent) : QAbstractL
     container->registerModel(this);
 }
 
-void ArrivalsModel::beginInsert(int rows) { beginInsertRows(QModelIndex(),0,rows);}
+void ArrivalsModel::beginInsert(int first, int last) { beginInsertRows(QModelIndex(),first,last);}
 
+//informs model that every row is to be removed
 void ArrivalsModel::beginRemove() {
     beginRemoveRows(QModelIndex(),0,rowCount() -1);
 }
 
+void ArrivalsModel::beginRemove(int first, int last) { beginRemoveRows(QModelIndex(),first,last); }
+
 //informs model that whatever is in the model is to be invalid
 void ArrivalsModel::beginReset() {
     beginResetModel();
@@ -62,6 +65,8 @@ QVariant ArrivalsModel::data(const QModelIndex& index, int role) const {
         return vehicle.type;
     case PlatformRole:
         return vehicle.platform;
+    case StaleRole:
+        return container->isStale();
     default:
         return QVariant();
     }
@@ -77,6 +82,12 @@ void ArrivalsModel::endReset() {
     endResetModel();
 }
 
+//informs views that the data of a single vehicle has changed
+void ArrivalsModel::notifyChanged(int row) {
+    QModelIndex changed = index(row);
+    emit dataChanged(changed, changed);
+}
+
 //swaps its container for another
 void ArrivalsModel::replaceContainer(const ArrivalsContainer& pOther) {
     container->replace(pOther);
@@ -91,6 +102,7 @@ QHash<int,QByteArray> ArrivalsModel::roleNames() const {
     roles[TowardRole] = "towardData";
     roles[TypeRole] = "typeData";
     roles[PlatformRole] = "platformData";
+    roles[StaleRole] = "staleData";//saved prediction that is waiting for a download
     return roles;
 }
 
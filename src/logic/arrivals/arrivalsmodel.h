@@ -36,18 +36,20 @@ class ArrivalsModel : public QAbstractListModel
 {
     Q_OBJECT
 public:
-    enum ArrivalsRoles { IdRole = Qt::UserRole + 1, LineRole, DestinationRole, EtaRole, TowardRole, TypeRole, PlatformRole };
+    enum ArrivalsRoles { IdRole = Qt::UserRole + 1, LineRole, DestinationRole, EtaRole, TowardRole, TypeRole, PlatformRole, StaleRole };
     explicit ArrivalsModel(ArrivalsContainer* = 0, QObject *parent = 0);
 private:
     ArrivalsContainer* container;
 public:
-    void beginInsert(int rows);
+    void beginInsert(int first, int last);
     void beginRemove();
+    void beginRemove(int first, int last);
     void beginReset();
     virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
     void endInsert();
     void endRemove();
     void endReset();
+    void notifyChanged(int row);
     void replaceContainer(const ArrivalsContainer&);
     virtual QHash<int,QByteArray> roleNames() const;
     virtual int rowCount(const QModelIndex& parent = QModelIndex() ) const;
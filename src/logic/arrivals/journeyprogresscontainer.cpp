@@ -23,65 +23,117 @@ THE SOFTWARE.
 */
 
 #include "journeyprogresscontainer.h"
+#include <QDateTime>
 #include <QDebug>
 #include <cmath>
 #include "arrivalsproxymodel.h"
 #include "journeyprogressmodel.h"
 
-//custom search algorithms because Qt algorithms are not sufficent and lambdas or bind is not available in C++03 to use std algorithms
 namespace {
-typedef QList<QPair<QString,double> > StopList;
-StopList::const_iterator find(StopList::const_iterator begin,StopList::const_iterator end, const QString& val) {
-    for (StopList::const_iterator iter = begin; iter != end; ++iter) {
-        if (iter->first == val) return iter;
-    }
-    return end;
-}
-
-StopList::iterator find(StopList::iterator begin,StopList::iterator end, const QString& val) {
-    for (StopList::iterator iter = begin; iter != end; ++iter) {
-        if (iter->first == val) return iter;
-    }
-    return end;
-}
+//stops passed longer ago than this are evicted so that tracking a vehicle for hours keeps the list short
+const double evictAfter = 600000;//10 min
+}//end of unnamed namespace
 
-//given a StopList container a time value and a current time value it returns the first element where
-//the elements time is less than the given time but more than the current time given
-//any other case it just returns end() iterator
-StopList::const_iterator findNextStop(StopList::const_iterator begin,StopList::const_iterator end, double val, double time) {
-    for (StopList::const_iterator iter = begin; iter != end; ++iter) {
-        if ((iter->second - time > 0)) {
-            //if the original time is in the past and this isn't, then this is still better match,
-            //otherwise only return if it is smaller then given value
-            if (val - time < 0 || iter->second < val) { return iter; }
-        }
-    }
-    return end;
+JourneyProgressContainer::JourneyPoint::JourneyPoint(const QString& n, double t, int eta) : name(n),
+                                                                                          shownEta(eta),
+                                                                                          time(t)
+{
 }
-}//end of unnamed namespace
 
 JourneyProgressContainer::JourneyProgressContainer(QObject* parent) : QObject(parent),
+                                                                      clockOffset(0),
                                                                       model(new JourneyProgressModel(this)),
-                                                                      proxyModel(new ArrivalsProxyModel(this))
+                                                                      nextRow(-1),
+                                                                      proxyModel(new ArrivalsProxyModel(this)),
+                                                                      terminated(false)
 {
     proxyModel->setSourceModel(model);
     proxyModel->sort(0);
 }
 
+//private:
+//current time on the server clock in msec from epoch
+double JourneyProgressContainer::currentTime() const {
+    return QDateTime::currentMSecsSinceEpoch() + clockOffset;
+}
+
+//removes stops the vehicle passed long ago, neighbouring rows are removed together from the back
+//so that rows are still valid, returns true if any stop was removed
+bool JourneyProgressContainer::evictPassed() {
+    double limit = currentTime() - evictAfter;
+    //the earliest stop tells if there is anything to evict at all
+    if (timeline.isEmpty() || timeline.begin().key() >= limit) return false;
+    int lowest = -1;
+    int row = data.size() - 1;
+    while (row >= 0) {
+        if (data.at(row).time >= limit) {
+            --row;
+            continue;
+        }
+        int last = row;
+        while (row > 0 && data.at(row - 1).time < limit) { --row; }
+        model->beginRemove(row, last);
+        for (int passed = row; passed <= last; ++passed) {
+            index.remove(data.at(passed).name);
+            removeFromTimeline(data.at(passed).time, data.at(passed).name);
+        }
+        data.erase(data.begin() + row, data.begin() + last + 1);
+        model->endRemove();
+        lowest = row;
+        --row;
+    }
+    if (lowest < 0) return false;
+    reindex(lowest);
+    //evicted stops were passed, if none is left ahead the journey is over
+    terminated = true;
+    updateNextStop();
+    return true;
+}
+
+//updates the row of every stop from row from, needed after rows are removed
+void JourneyProgressContainer::reindex(int from) {
+    for (int row = from; row < data.size(); ++row) {
+        index.insert(data.at(row).name, row);
+    }
+}
+
+//removes a single stop from the timeline, stops predicted for the same time are told apart by name
+void JourneyProgressContainer::removeFromTimeline(double time, const QString& name) {
+    QMultiMap<double,QString>::iterator iter = timeline.find(time, name);
+    if (iter != timeline.end()) { timeline.erase(iter); }
+}
+
+//looks up the first stop ahead of the vehicle in the timeline, it is O(log n) so it can be called on every tick
+//returns true if the next stop changed
+bool JourneyProgressContainer::updateNextStop() {
+    int row = -1;
+    QMultiMap<double,QString>::const_iterator next = timeline.upperBound(currentTime());
+    if (next != timeline.constEnd()) { row = index.value(next.value(), -1); }
+    terminated = row < 0 && (terminated || !timeline.isEmpty());
+    if (row == nextRow) return false;
+    nextRow = row;
+    return true;
+}
+
 //public:
-QPair<QString,double> JourneyProgressContainer::at(int index) const { return data.at(index); }
+QPair<QString,double> JourneyProgressContainer::at(int row) const {
+    return qMakePair(data.at(row).name, data.at(row).time);
+}
 
 //clears data and notifies model
 void JourneyProgressContainer::clear() {
     model->beginReset();
     data.clear();
+    index.clear();
+    timeline.clear();
+    nextRow = -1;
+    terminated = false;
     model->endReset();
 }
 
-//counts difference between 2 datetime objects in sec or millisec
-//time is server time saved when downloading the data from server
+//counts difference between a prediction and the current time on the server clock in millisec
 double JourneyProgressContainer::getDeltaTime(double prediction) const {
-    double delta = prediction - time;
+    double delta = prediction - currentTime();
     return delta;
 }
 
@@ -98,58 +150,86 @@ int JourneyProgressContainer::getEta(double prediction) const {
 
 ArrivalsProxyModel* JourneyProgressContainer::getModel() { return proxyModel; }
 
-//Returns the next stop where vehicle is scheduled to stop
+//Returns the next stop where vehicle is scheduled to stop, it is kept up to date by refreshData() and refreshEtas()
+//a terminated vehicle is reported even after its passed stops are evicted
 QString JourneyProgressContainer::getNextStop() const {
-    QList<QPair<QString,double> >::const_iterator smallestSoFar = data.begin(), iter = data.begin();
-    while (iter < data.end()) {
-        smallestSoFar = iter;
-        iter = findNextStop(iter,data.end(),smallestSoFar->second,time);
-    }
-    if (smallestSoFar != data.end()) {
-        double eta = smallestSoFar->second;
-        double theTime = time;
-        if (eta - theTime < 0) {
-            return QString("TERMINATED");
-        }
-        else return smallestSoFar->first;
-    }
-    else {
-        return QString("NOT AVAILABLE");
-    }
+    if (nextRow >= 0) { return data.at(nextRow).name; }
+    if (terminated) { return QString("TERMINATED"); }
+    return QString("NOT AVAILABLE");
 }
 
-//it is called when new data is available, it appends the container with the new stop-eta pairs only
-//if they are not already present otherwise just update eta to the new value,
-//old data is not deleted until user changes the vehicle to track
-//not using a QMap/QHash, because it needs random access iterators for model
-void JourneyProgressContainer::refreshData(QList<QPair<QString,double> > list) {
-    //check if other element is in data if yes update if no then set to 0 or delete
-    if (!data.empty()) {
-        model->beginReset();
-        //check if some elements are already part of data, then just update them with a new time(double)
-        for (QList<QPair<QString,double> >::iterator iter = data.begin();iter != data.end(); ++iter) {
-            QList<QPair<QString,double> >::iterator match = find(list.begin(),list.end(),iter->first);
-            //if both contain the same Stop then update to the new eta in data and then remove item from list
-            if (match != list.end()) {
-                iter->second = match->second;
-                list.removeAt(match-list.begin());
+//returns the seconds until the vehicle reaches its next stop or -1 if it is not going to stop anymore
+double JourneyProgressContainer::getSecondsToNextStop() const {
+    if (nextRow < 0) { return -1; }
+    return qMax(0.0, (data.at(nextRow).time - currentTime()) / 1000);
+}
+
+//it is called when new data is available, stops already present are updated in place and only the ones
+//whose eta changed are reported to the model, new stops are appended
+//stops missing from list are kept until they are evicted, a partial list ie: from the stream is fine
+//returns the average change of predictions in sec of stops already present or -1 if there is none
+double JourneyProgressContainer::refreshData(const QList<QPair<QString,double> >& list) {
+    double change = 0;
+    int updated = 0;
+    QList<JourneyPoint> added;
+    for (QList<QPair<QString,double> >::const_iterator iter = list.begin(); iter != list.end(); ++iter) {
+        QHash<QString,int>::const_iterator row = index.find(iter->first);
+        if (row == index.end()) {
+            index.insert(iter->first, data.size() + added.size());
+            timeline.insert(iter->second, iter->first);
+            added << JourneyPoint(iter->first, iter->second, getEta(iter->second));
+            continue;
+        }
+        //stop listed twice in the same update
+        if (*row >= data.size()) {
+            JourneyPoint& point = added[*row - data.size()];
+            removeFromTimeline(point.time, point.name);
+            timeline.insert(iter->second, iter->first);
+            point = JourneyPoint(iter->first, iter->second, getEta(iter->second));
+            continue;
+        }
+        JourneyPoint& point = data[*row];
+        change += qAbs(iter->second - point.time) / 1000;
+        ++updated;
+        int eta = getEta(iter->second);
+        if (point.time != iter->second || point.shownEta != eta) {
+            if (point.time != iter->second) {
+                removeFromTimeline(point.time, point.name);
+                timeline.insert(iter->second, point.name);
             }
+            point.time = iter->second;
+            point.shownEta = eta;
+            model->notifyChanged(*row);
         }
-        model->endReset();
     }
-    //any (remaining)elements of list that wasn't/isn't in data will now be inserted if list is empty then nothing to do
-    if (list.size() ) {
-        model->beginInsert(data.size(),data.size() + list.size()-1);
-        for (QList<QPair<QString,double> >::const_iterator iter = list.begin();iter != list.end(); ++iter) {
-            data.append(*iter);
-        }
+    if (!added.isEmpty()) {
+        model->beginInsert(data.size(), data.size() + added.size() - 1);
+        data.append(added);
         model->endInsert();
     }
+    evictPassed();
+    updateNextStop();
     emit dataChanged();
+    return updated ? change / updated : -1;
 }
 
+//works out etas again with the current time so that they count down between downloads,
+//only stops whose eta changed are reported to the model, dataChanged() is only emitted if the next stop changed
+void JourneyProgressContainer::refreshEtas() {
+    bool evicted = evictPassed();
+    for (int row = 0; row != data.size(); ++row) {
+        JourneyPoint& point = data[row];
+        int eta = getEta(point.time);
+        if (point.shownEta != eta) {
+            point.shownEta = eta;
+            model->notifyChanged(row);
+        }
+    }
+    bool nextChanged = updateNextStop();
+    if (evicted || nextChanged) { emit dataChanged(); }
+}
 
-void JourneyProgressContainer::setTime(double t) { time = t; }
+//sets the difference between server clock and device clock in msec
+void JourneyProgressContainer::setClockOffset(double offset) { clockOffset = offset; }
 
 int JourneyProgressContainer::size() const { return data.size(); }
-
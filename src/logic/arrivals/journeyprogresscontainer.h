@@ -25,24 +25,45 @@ THE SOFTWARE.
 #ifndef JOURNEYPROGRESSCONTAINER_H
 #define JOURNEYPROGRESSCONTAINER_H
 
+#include <QHash>
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QPair>
+#include <QString>
 
 class ArrivalsProxyModel;
 class JourneyProgressModel;
 
 //container to hold journey progress data ie: what stops are coming up at what eta
+//rows keep the order they were first seen in, an index by stop name makes updates O(1) per stop
 class JourneyProgressContainer : public QObject
 {
     Q_OBJECT
 public:
     explicit JourneyProgressContainer(QObject* parent);
 private:
-    QList<QPair<QString,double>> data;
-    double time;
+    //a stop of the journey and its predicted time
+    struct JourneyPoint {
+        JourneyPoint(const QString& name = QString(), double time = 0, int shownEta = 0);
+        QString name;
+        int shownEta;//eta in minutes as last reported to views
+        double time;
+    };
+    double clockOffset;//server clock - device clock in msec
+    QList<JourneyPoint> data;
+    QHash<QString,int> index;//stop name -> row
     JourneyProgressModel* model;
+    int nextRow;//row of the next stop, -1 if there is none
     ArrivalsProxyModel* proxyModel;
+    bool terminated;//the vehicle passed every stop it was predicted for, they might have been evicted since
+    QMultiMap<double,QString> timeline;//stop names ordered by predicted time
+private:
+    double currentTime() const;
+    bool evictPassed();
+    void reindex(int from);
+    void removeFromTimeline(double time, const QString& name);
+    bool updateNextStop();
 public:
     QPair<QString,double> at(int index) const;
     void clear();
@@ -50,9 +71,11 @@ public:
     int getEta(double) const; //returns in minutes
     ArrivalsProxyModel* getModel();
     QString getNextStop() const;
-    void refreshData(QList<QPair<QString,double>>);
+    double getSecondsToNextStop() const;
+    double refreshData(const QList<QPair<QString,double> >&);
+    void refreshEtas();
+    void setClockOffset(double);
     int size() const;
-    void setTime(double);
 signals:
     void dataChanged();
 };
@@ -33,6 +33,8 @@ JourneyProgressModel::JourneyProgressModel(QObject *parent) :
 
 void JourneyProgressModel::beginInsert(int first, int last) { beginInsertRows(QModelIndex(),first,last);}
 
+void JourneyProgressModel::beginRemove(int first, int last) { beginRemoveRows(QModelIndex(),first,last); }
+
 void JourneyProgressModel::beginReset() { beginResetModel();}
 
 QVariant JourneyProgressModel::data(const QModelIndex& index, int role) const {
@@ -50,8 +52,16 @@ QVariant JourneyProgressModel::data(const QModelIndex& index, int role) const {
 
 void JourneyProgressModel::endInsert() { endInsertRows(); }
 
+void JourneyProgressModel::endRemove() { endRemoveRows(); }
+
 void JourneyProgressModel::endReset() { endResetModel();}
 
+//informs views that the eta of a single stop has changed
+void JourneyProgressModel::notifyChanged(int row) {
+    QModelIndex changed = index(row);
+    emit dataChanged(changed, changed);
+}
+
 QHash<int,QByteArray> JourneyProgressModel::roleNames() const {
     QHash<int,QByteArray> roles;
     roles[SortRole] = "sortData";
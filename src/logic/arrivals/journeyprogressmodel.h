@@ -43,10 +43,13 @@ private:
     JourneyProgressContainer* container;
 public:
     void beginInsert(int first, int last);
+    void beginRemove(int first, int last);
     void beginReset();
     virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
     void endInsert();
+    void endRemove();
     void endReset();
+    void notifyChanged(int row);
     virtual QHash<int,QByteArray> roleNames() const;
     virtual int rowCount(const QModelIndex& parent = QModelIndex() ) const;
 };
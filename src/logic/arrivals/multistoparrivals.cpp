@@ -0,0 +1,366 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "multistoparrivals.h"
+#include <QTimer>
+#include <QUrl>
+#include "../database/databasemanager.h"
+#include "../network/requestmanager.h"
+#include "arrivalsmodel.h"
+#include "arrivalsproxymodel.h"
+#include "urareader.h"
+#include "urastream.h"
+#include "vehicle.h"
+
+MultiStopArrivals::MultiStopArrivals(RequestManager* mngr, DatabaseManager* dbm, QObject* parent) : QObject(parent),
+                                                    baseUrl(UraReader::getServerUrl() + "instant_V1?"),
+                                                    clock(new QTimer(this)),
+                                                    databaseManager(dbm),
+                                                    downloading(false),
+                                                    reader(new UraReader(QStringList() << "StopCode1" << "LineName" << "DestinationName"
+                                                                                       << "EstimatedTime" << "RegistrationNumber" << "DirectionID", this)),
+                                                    requestManager(mngr),
+                                                    running(false),
+                                                    stream(new UraStream(mngr, QStringList() << "StopCode1" << "LineName" << "DestinationName"
+                                                                                             << "EstimatedTime" << "RegistrationNumber" << "DirectionID",
+                                                                         "arrivalsStream", this)),
+                                                    streaming(false),
+                                                    timer(new QTimer(this))
+{
+    connect(timer, SIGNAL(timeout()), this, SLOT(fetch()) );
+    connect(clock, SIGNAL(timeout()), this, SLOT(onClockTicked()) );
+    connect(reader, SIGNAL(predictionDecoded(UraPrediction)), this, SLOT(onPredictionDecoded(UraPrediction)) );
+    connect(reader, SIGNAL(finished()), this, SLOT(onDataReceived()) );
+    connect(stream->getReader(), SIGNAL(predictionDecoded(UraPrediction)), this, SLOT(onStreamedPredictionDecoded(UraPrediction)) );
+    connect(stream->getReader(), SIGNAL(chunkDecoded()), this, SLOT(onStreamDecoded()) );
+    connect(stream, SIGNAL(broken()), this, SLOT(onStreamStateChanged()) );
+    connect(stream, SIGNAL(established()), this, SLOT(onStreamStateChanged()) );
+}
+
+MultiStopArrivals::~MultiStopArrivals() {
+    //containers are not QObjects, models are deleted by their parent
+    for (QHash<QString,StopArrivals>::iterator iter = stops.begin(); iter != stops.end(); ++iter) {
+        delete iter->container;
+    }
+}
+
+//private:
+//creates a container and its models for a stop code, filled with the saved predictions of the stop
+void MultiStopArrivals::addStop(const QString& code) {
+    if (stops.contains(code)) return;
+    StopArrivals entry;
+    entry.container = new ArrivalsContainer();
+    //filled before the models see it
+    if (databaseManager) {
+        entry.container->append(databaseManager->loadArrivals(code));
+        entry.container->setStale(!entry.container->isEmpty());
+    }
+    entry.model = new ArrivalsModel(entry.container, this);
+    entry.proxyModel = new ArrivalsProxyModel(this);
+    entry.proxyModel->setSourceModel(entry.model);
+    entry.proxyModel->sort(0);
+    stops.insert(code, entry);
+}
+
+//makes a vehicle of a decoded prediction and adds it to the container of its stop in target
+void MultiStopArrivals::addVehicle(QHash<QString,ArrivalsContainer>& target, const UraPrediction& prediction, const UraReader* from) {
+    //eta would be invalid without server time, stops unsubscribed since the request was sent are left out
+    if (!from->getServerTime() || !stops.contains(prediction.stopCode)) return;
+    Vehicle bus;
+    bus.line = prediction.line;
+    bus.destination = prediction.destination;
+    bus.direction = prediction.directionId;
+    bus.id = prediction.registration;
+    bus.estimatedTime = prediction.estimatedTime;
+    bus.clockOffset = from->getClockOffset();
+    bus.updateEta();
+    target[prediction.stopCode].add(bus);
+}
+
+//deletes the container and the models of a stop code,
+//vehicles pushed by the stream since the last download are saved first
+void MultiStopArrivals::removeStop(const QString& code) {
+    QHash<QString,StopArrivals>::iterator iter = stops.find(code);
+    if (iter == stops.end()) return;
+    if (databaseManager && !iter->container->isStale()) { databaseManager->saveArrivals(code, *iter->container); }
+    iter->proxyModel->deleteLater();
+    iter->model->deleteLater();
+    //model might still call back into container until it is deleted
+    iter->container->clearData();
+    iter->container->registerModel(0);
+    delete iter->container;
+    stops.erase(iter);
+}
+
+//restarts the timer so that the next download is scheduled according to the arrivals and visibility,
+//polling only continues until the stream delivers data or while it is broken
+void MultiStopArrivals::schedule(double secondsToNext) {
+    updateStream();
+    if (stream->isLive()) { timer->stop(); }
+    else { timer->start(scheduler.nextInterval(secondsToNext)); }
+}
+
+//fetches data right away then periodically, see PollScheduler for how often
+void MultiStopArrivals::start() {
+    running = true;
+    scheduler.reset();
+    fetch();
+    schedule(-1);
+    clock->start(10000);//10 sec is plenty for whole minutes
+}
+
+void MultiStopArrivals::stop() {
+    running = false;
+    timer->stop();
+    clock->stop();
+    stream->stop();
+    streamed.clear();
+}
+
+//keeps a single stream open for every subscribed stop while they are visible,
+//it is reconnected whenever a stop is subscribed or dropped
+void MultiStopArrivals::updateStream() {
+    if (streaming && running && scheduler.getVisibility() != PollScheduler::Hidden) {
+        QStringList codes = stops.keys();
+        codes.sort();//the same stops are the same query
+        stream->start(QString("StopCode1=") + codes.join(","));
+    }
+    else { stream->stop(); }
+}
+
+//public:
+//returns the DirectionID of a vehicle arriving at any of the stops or an empty string if it is not known
+QString MultiStopArrivals::getDirection(const QString& vehicleId) const {
+    for (QHash<QString,StopArrivals>::const_iterator iter = stops.begin(); iter != stops.end(); ++iter) {
+        for (ArrivalsContainer::const_iterator vehicle = iter->container->begin(); vehicle != iter->container->end(); ++vehicle) {
+            if (vehicle->id == vehicleId && !vehicle->direction.isEmpty()) { return vehicle->direction; }
+        }
+    }
+    return QString();
+}
+
+//returns a model sorted by eta for a stop or a nullptr if the stop is not being tracked
+ArrivalsProxyModel* MultiStopArrivals::getModel(const QString& code) {
+    QHash<QString,StopArrivals>::const_iterator iter = stops.find(code);
+    if (iter == stops.end()) return 0;
+    return iter->proxyModel;
+}
+
+//returns the line name of the vehicle arriving first at a stop or an empty string,
+//vehicles that have left since the last download are skipped
+QString MultiStopArrivals::getNextLine(const QString& code) const {
+    QHash<QString,StopArrivals>::const_iterator iter = stops.find(code);
+    if (iter == stops.end()) return QString();
+    QString line;
+    int eta = 9999;
+    for (ArrivalsContainer::const_iterator vehicle = iter->container->begin(); vehicle != iter->container->end(); ++vehicle) {
+        if (vehicle->eta >= 0 && vehicle->eta < eta) {
+            eta = vehicle->eta;
+            line = vehicle->line;
+        }
+    }
+    return line;
+}
+
+//returns the eta in minutes of the vehicle arriving first at a stop or -1 if there is none,
+//vehicles that have left since the last download are skipped
+int MultiStopArrivals::getNextEta(const QString& code) const {
+    QHash<QString,StopArrivals>::const_iterator iter = stops.find(code);
+    if (iter == stops.end()) return -1;
+    int eta = -1;
+    for (ArrivalsContainer::const_iterator vehicle = iter->container->begin(); vehicle != iter->container->end(); ++vehicle) {
+        if (vehicle->eta >= 0 && (eta < 0 || vehicle->eta < eta)) { eta = vehicle->eta; }
+    }
+    return eta;
+}
+
+//returns how much of the time to the next download has passed in percent, 0 while there is nothing to wait for
+double MultiStopArrivals::getTimerProgress() const {
+    if (!timer->isActive()) { return 0; }
+    double interval = timer->interval();
+    double remaining = timer->remainingTime();
+    return (interval - remaining) / interval * 100;
+}
+
+int MultiStopArrivals::getVisibility() const { return scheduler.getVisibility(); }
+
+bool MultiStopArrivals::isDownloading() const { return downloading; }
+
+//returns true if stops are updated either by polling or by the stream
+bool MultiStopArrivals::isRunning() const { return running; }
+
+bool MultiStopArrivals::isStreamingEnabled() const { return streaming; }
+
+//makes the views of a stop lay out every row again
+void MultiStopArrivals::refresh(const QString& code) {
+    QHash<QString,StopArrivals>::const_iterator iter = stops.find(code);
+    if (iter != stops.end()) { iter->model->refresh(); }
+}
+
+//switches between streaming and polling
+void MultiStopArrivals::setStreamingEnabled(bool enabled) {
+    if (streaming == enabled) return;
+    streaming = enabled;
+    if (running) { schedule(-1); }
+}
+
+//sets how visible the stops are to user, see PollScheduler::Visibility
+void MultiStopArrivals::setVisibility(int visibility) {
+    if (visibility == scheduler.getVisibility()) return;
+    bool wasHidden = scheduler.getVisibility() == PollScheduler::Hidden;
+    scheduler.setVisibility(visibility);
+    if (!running) return;
+    //data is likely to be out of date after being hidden
+    if (wasHidden) { fetch(); }
+    schedule(-1);
+}
+
+QStringList MultiStopArrivals::stopCodes() const { return stops.keys(); }
+
+//registers a view of a stop and returns the model shared by every view of that stop,
+//the first subscriber of a stop gets it downloaded with the next request
+ArrivalsProxyModel* MultiStopArrivals::subscribe(const QString& code) {
+    if (code.isEmpty()) return 0;
+    int& count = subscribers[code];
+    if (++count == 1) {
+        addStop(code);
+        //a download already on its way is followed by another one, see onDataReceived()
+        if (!running) { start(); }
+        else {
+            fetch();
+            updateStream();
+        }
+    }
+    return stops.value(code).proxyModel;
+}
+
+int MultiStopArrivals::subscriberCount(const QString& code) const { return subscribers.value(code); }
+
+//unregisters a view of a stop, the stop is dropped once its last subscriber left
+//and polling stops when there are no more stops
+void MultiStopArrivals::unsubscribe(const QString& code) {
+    QHash<QString,int>::iterator iter = subscribers.find(code);
+    if (iter == subscribers.end()) return;
+    if (--iter.value() > 0) return;
+    subscribers.erase(iter);
+    removeStop(code);
+    if (stops.isEmpty()) { stop(); }
+    else { updateStream(); }
+}
+
+//private slots:
+//works out etas again so that they count down between downloads
+void MultiStopArrivals::onClockTicked() {
+    bool changed = false;
+    for (QHash<QString,StopArrivals>::iterator iter = stops.begin(); iter != stops.end(); ++iter) {
+        //nothing tells when a streamed vehicle has left
+        if (stream->isLive() && iter->container->removeDeparted(30000)) { changed = true; }
+        if (iter->container->refreshEtas()) { changed = true; }
+    }
+    if (changed) { emit dataChanged(); }
+}
+
+//gives each stop its new set of vehicles even if it is empty,
+//so that vehicles that already left don't stay on display
+void MultiStopArrivals::onDataReceived() {
+    downloading = false;
+    emit downloadStateChanged();
+    //keep showing the last data if the download went awry
+    if (!reader->hasError() && reader->getServerTime()) {
+        double change = 0;
+        int compared = 0;
+        double secondsToNext = -1;
+        for (QHash<QString,StopArrivals>::iterator iter = stops.begin(); iter != stops.end(); ++iter) {
+            if (!requested.contains(iter.key())) continue;
+            double stopChange = iter->container->replace(received.value(iter.key()));
+            if (databaseManager) { databaseManager->saveArrivals(iter.key(), *iter->container); }
+            if (stopChange >= 0) {
+                change += stopChange;
+                ++compared;
+            }
+            double toNext = iter->container->getSecondsToNext();
+            if (toNext >= 0 && (secondsToNext < 0 || toNext < secondsToNext)) { secondsToNext = toNext; }
+        }
+        scheduler.recordChange(compared ? change / compared : -1);
+        if (running) { schedule(secondsToNext); }
+        emit dataChanged();
+    }
+    received.clear();
+    //stops subscribed while downloading weren't part of the request
+    bool missing = false;
+    for (QHash<QString,StopArrivals>::const_iterator iter = stops.begin(); iter != stops.end(); ++iter) {
+        if (!requested.contains(iter.key())) { missing = true; }
+    }
+    requested.clear();
+    if (missing) { fetch(); }
+}
+
+//splits the reply by stop code as vehicles are decoded
+void MultiStopArrivals::onPredictionDecoded(const UraPrediction& prediction) {
+    addVehicle(received, prediction, reader);
+}
+
+//vehicles pushed by the stream are only updated or added, the ones that left are removed by the clock
+void MultiStopArrivals::onStreamDecoded() {
+    if (streamed.isEmpty()) return;
+    double change = 0;
+    int compared = 0;
+    for (QHash<QString,ArrivalsContainer>::const_iterator iter = streamed.begin(); iter != streamed.end(); ++iter) {
+        QHash<QString,StopArrivals>::iterator entry = stops.find(iter.key());
+        if (entry == stops.end()) continue;
+        double stopChange = entry->container->merge(iter.value());
+        if (stopChange >= 0) {
+            change += stopChange;
+            ++compared;
+        }
+    }
+    scheduler.recordChange(compared ? change / compared : -1);
+    streamed.clear();
+    emit dataChanged();
+}
+
+//gets called for every vehicle pushed by the stream
+void MultiStopArrivals::onStreamedPredictionDecoded(const UraPrediction& prediction) {
+    addVehicle(streamed, prediction, stream->getReader());
+}
+
+//stops polling when the stream delivers data and polls again straight away when it breaks
+void MultiStopArrivals::onStreamStateChanged() {
+    if (!running) return;
+    if (!stream->isLive()) { fetch(); }
+    schedule(-1);
+}
+
+//public slots:
+//downloads arrivals for every tracked stop in one request
+void MultiStopArrivals::fetch() {
+    if (!requestManager || stops.isEmpty() || downloading) return;
+    requested = stops.keys();
+    QString stopCode = QString("StopCode1=") + requested.join(",");
+    QUrl url(baseUrl + stopCode + reader->getReturnList());
+    downloading = true;
+    emit downloadStateChanged();
+    received.clear();
+    reader->read(requestManager->get(url, RequestManager::Foreground, "arrivals"));
+}
@@ -0,0 +1,117 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef MULTISTOPARRIVALS_H
+#define MULTISTOPARRIVALS_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "arrivalscontainer.h"
+#include "pollscheduler.h"
+#include "urarecords.h"
+
+class ArrivalsModel;
+class ArrivalsProxyModel;
+class DatabaseManager;
+class QTimer;
+class RequestManager;
+class UraReader;
+class UraStream;
+
+//This class downloads arrivals for a number of stops with a single Countdown request
+//and splits the reply by stop code into one ArrivalsContainer per stop.
+//Views subscribe to the stops they show and share the container of a stop,
+//stops are polled while they have at least one subscriber.
+//If streaming is enabled the subscribed stops are pushed by a single stream while they are visible
+class MultiStopArrivals : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MultiStopArrivals(RequestManager* = 0, DatabaseManager* = 0, QObject* parent = 0);
+    ~MultiStopArrivals();
+private:
+    //everything that belongs to a single stop, models are deleted by Qt memory management
+    struct StopArrivals {
+        ArrivalsContainer* container;
+        ArrivalsModel* model;
+        ArrivalsProxyModel* proxyModel;
+    };
+    QString baseUrl;
+    QTimer* clock;//etas count down between downloads
+    DatabaseManager* databaseManager;//last known predictions are saved and shown before the first download
+    bool downloading;
+    UraReader* reader;
+    QHash<QString,ArrivalsContainer> received;//vehicles decoded so far by stop code
+    RequestManager* requestManager;
+    QStringList requested;//stops asked for by the download under way
+    bool running;
+    PollScheduler scheduler;
+    QHash<QString,StopArrivals> stops;
+    UraStream* stream;
+    QHash<QString,ArrivalsContainer> streamed;//pushed by the stream but not yet in containers
+    bool streaming;//stream predictions instead of polling while they are visible
+    QHash<QString,int> subscribers;//number of views subscribed by stop code
+    QTimer* timer;
+private:
+    void addStop(const QString& code);
+    void addVehicle(QHash<QString,ArrivalsContainer>& target, const UraPrediction&, const UraReader*);
+    void removeStop(const QString& code);
+    void schedule(double secondsToNext);
+    void start();
+    void stop();
+    void updateStream();
+public:
+    QString getDirection(const QString& vehicleId) const;
+    ArrivalsProxyModel* getModel(const QString& code);
+    QString getNextLine(const QString& code) const;
+    int getNextEta(const QString& code) const;
+    double getTimerProgress() const;
+    int getVisibility() const;
+    bool isDownloading() const;
+    bool isRunning() const;
+    bool isStreamingEnabled() const;
+    void refresh(const QString& code);
+    void setStreamingEnabled(bool);
+    void setVisibility(int);
+    QStringList stopCodes() const;
+    ArrivalsProxyModel* subscribe(const QString& code);
+    int subscriberCount(const QString& code) const;
+    void unsubscribe(const QString& code);
+signals:
+    void dataChanged();
+    void downloadStateChanged();
+private slots:
+    void onClockTicked();
+    void onDataReceived();
+    void onPredictionDecoded(const UraPrediction&);
+    void onStreamDecoded();
+    void onStreamedPredictionDecoded(const UraPrediction&);
+    void onStreamStateChanged();
+public slots:
+    void fetch();
+};
+
+#endif // MULTISTOPARRIVALS_H
@@ -0,0 +1,84 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "pollscheduler.h"
+#include <QtGlobal>
+
+namespace {
+const int minInterval = 10000;//10 sec
+const int maxInterval = 600000;//10 min
+const int hiddenInterval = 300000;//5 min
+}//end of unnamed namespace
+
+PollScheduler::PollScheduler() : samples(0),
+                                 volatility(0),
+                                 visibility(OnScreen)
+{
+}
+
+int PollScheduler::getVisibility() const { return visibility; }
+
+//returns the time in msec until the next download given the seconds until the next arrival,
+//secondsToNext is negative if nothing is due
+int PollScheduler::nextInterval(double secondsToNext) const {
+    int interval;
+    if (secondsToNext < 0) { interval = 120000; }
+    else if (secondsToNext <= 120) { interval = 10000; }
+    else if (secondsToNext <= 300) { interval = 20000; }
+    else if (secondsToNext <= 600) { interval = 30000; }
+    else if (secondsToNext <= 1200) { interval = 60000; }
+    else { interval = 120000; }
+
+    //predictions that jump around need checking more often, steady ones less often
+    if (samples) {
+        if (volatility > 60) { interval /= 2; }
+        else if (volatility < 10) { interval = interval * 3 / 2; }
+    }
+
+    switch (visibility) {
+    case OnScreen:
+        break;
+    case OnCover:
+        interval *= 2;
+        break;
+    default:
+        interval = qMax(interval * 4, hiddenInterval);
+    }
+    return qBound(minInterval, interval, maxInterval);
+}
+
+//records the average change of predictions in sec between the last two downloads
+void PollScheduler::recordChange(double change) {
+    if (change < 0) return;//nothing to compare
+    volatility = samples ? (volatility + change) / 2 : change;
+    ++samples;
+}
+
+//forgets the history of changes, to be called when a different stop or vehicle is tracked
+void PollScheduler::reset() {
+    samples = 0;
+    volatility = 0;
+}
+
+void PollScheduler::setVisibility(int value) { visibility = value; }
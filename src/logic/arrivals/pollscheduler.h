@@ -0,0 +1,49 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+//This class works out when predictions should be downloaded next
+//it polls often when a vehicle is about to arrive or predictions keep changing
+//and backs off when nothing is due or the data is not on display
+class PollScheduler
+{
+public:
+    //how visible the data is, values match CoverLogic::Visibility
+    enum Visibility { Hidden, OnCover, OnScreen };
+    PollScheduler();
+private:
+    int samples;
+    double volatility;//smoothed average change of predictions between downloads in sec
+    int visibility;
+public:
+    int getVisibility() const;
+    int nextInterval(double secondsToNext) const;
+    void recordChange(double change);
+    void reset();
+    void setVisibility(int);
+};
+
+#endif // POLLSCHEDULER_H
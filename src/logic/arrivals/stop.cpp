@@ -28,7 +28,10 @@ THE SOFTWARE.
 
 // !!! see header for note about parent !!!
 Stop::Stop(QObject* parent) : QObject(parent),
-                              databaseManager(static_cast<DatabaseManager*>(parent))
+                              databaseManager(static_cast<DatabaseManager*>(parent)),
+                              latitude(0),
+                              longitude(0),
+                              type(None)
 {
 }
 
@@ -37,6 +40,7 @@ Stop::Stop(QObject* parent) : QObject(parent),
 void Stop::setID(const QString& value) { id = value; }
 void Stop::setLatitude(double value) { latitude = value; }
 void Stop::setLongitude(double value) { longitude = value; }
+void Stop::setMessages(const QString& value) { messages = value; }
 void Stop::setName(const QString& value) { name = value;}
 void Stop::setStopPointIndicator(const QString& value) { stopPointIndicator = value; }
 void Stop::setTowards(const QString& value) { towards = value; }
@@ -58,6 +62,7 @@ void Stop::clear() {
     id = "";
     latitude = 0;
     longitude = 0;
+    messages = "";
     name = "";
     stopPointIndicator = "";
     towards = "";
@@ -69,6 +74,7 @@ void Stop::clear() {
 QString Stop::getID() const { return id; }
 double Stop::getLatitude() const { return latitude; }
 double Stop::getLongitude() const { return longitude; }
+QString Stop::getMessages() const { return messages; }
 QString Stop::getName() const { return name; }
 QString Stop::getStopPointIndicator() const { return stopPointIndicator; }
 QString Stop::getTowards() const { return towards; }
@@ -46,6 +46,7 @@ private:
     QString id;
     double latitude;//will be replaced with QCoordinates
     double longitude;//   -||-
+    QString messages;//active messages of TfL about the stop
     QString name;
     QString stopPointIndicator;//for bus stops
     QString towards;//might be empty string for some types such as Underground
@@ -54,6 +55,7 @@ public:
     void setID(const QString&);
     void setLatitude(double);
     void setLongitude(double);
+    void setMessages(const QString&);
     void setName(const QString&);
     void setStopPointIndicator(const QString&);
     void setTowards(const QString&);
@@ -67,6 +69,7 @@ public slots:
     QString getID() const;
     double getLatitude() const;
     double getLongitude() const;
+    QString getMessages() const;
     QString getName() const;
     QString getStopPointIndicator() const;
     QString getTowards() const;
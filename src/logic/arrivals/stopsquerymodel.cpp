@@ -26,47 +26,184 @@ THE SOFTWARE.
 #include "stopsquerymodel.h"
 #include <QDebug>
 #include <QHash>
-#include <QSqlRecord>
+#include <QSqlDatabase>
+#include <QSqlError>
 #include <QSqlQuery>
+#include <QVariant>
 #include "../database/databasemanager.h"
 #include "stop.h"
 
 extern DatabaseManager databaseManager;
 
+namespace {
+    //columns are read by position, see StopsQueryModel::read()
+    const char* columns = "SELECT name, code, type, towards, latitude, longitude, stoppointindicator, rank FROM stopstable ";
+    const int pageSize = 100;
+}//end of unnamed namespace
+
 // !!! See header for note on parent !!!
-StopsQueryModel::StopsQueryModel(QObject *parent) : QSqlQueryModel(parent),
-                                                    databaseManager(static_cast<DatabaseManager*>(parent))
+StopsQueryModel::StopsQueryModel(QObject *parent) : QAbstractListModel(parent),
+                                                    databaseManager(static_cast<DatabaseManager*>(parent)),
+                                                    fetched(0)
 {
+    if (databaseManager) {
+        connect(databaseManager, SIGNAL(favoriteMoved(QString,bool)), this, SLOT(onFavoriteMoved(QString,bool)) );
+        connect(databaseManager, SIGNAL(stopsCleared(bool)), this, SLOT(onStopsCleared(bool)) );
+        connect(databaseManager, SIGNAL(stopsIndexed()), this, SLOT(onStopsIndexed()) );
+    }
+}
+
+//private:
+//returns the row of a stop or -1 if it is not in the model
+int StopsQueryModel::indexOf(const QString& code) const {
+    for (int row = 0; row != rows.size(); ++row) {
+        if (rows.at(row).code == code) { return row; }
+    }
+    return -1;
+}
+
+//replaces every row with the result of an executed query, views get the first page only
+void StopsQueryModel::load(QSqlQuery& query) {
+    beginResetModel();
+    rows = read(query);
+    fetched = qMin(rows.size(), pageSize);
+    numberFavorites();
+    endResetModel();
+}
+
+//works out the place of favorites in the order they are in, views are told about the ones that changed
+void StopsQueryModel::numberFavorites() {
+    int position = 0;
+    for (int row = 0; row != rows.size(); ++row) {
+        StopRow& stop = rows[row];
+        int current = stop.rank ? ++position : 0;
+        if (current == stop.position) continue;
+        stop.position = current;
+        if (row < fetched) { emit dataChanged(index(row), index(row)); }
+    }
+}
+
+//returns the rows of an executed query that selected columns
+QVector<StopsQueryModel::StopRow> StopsQueryModel::read(QSqlQuery& query) const {
+    QVector<StopRow> ret;
+    while (query.next()) {
+        StopRow stop;
+        stop.name = query.value(0).toString();
+        stop.code = query.value(1).toString();
+        stop.type = query.value(2).toInt();
+        stop.towards = query.value(3).toString();
+        stop.latitude = query.value(4).toDouble();
+        stop.longitude = query.value(5).toDouble();
+        stop.stopPointIndicator = query.value(6).toString();
+        stop.rank = query.value(7).toLongLong();
+        stop.position = 0;
+        ret << stop;
+    }
+    return ret;
+}
+
+//rows are read through a read-only connection so that they don't wait for the executor
+QSqlDatabase StopsQueryModel::reader() const {
+    return databaseManager ? databaseManager->getReader() : QSqlDatabase::database();
+}
+
+//selects the stops with the given codes, favorites first, returns false if the query failed
+bool StopsQueryModel::selectCodes(QSqlQuery& query, const QStringList& codes) const {
+    QStringList placeholders;
+    for (int i = 0; i != codes.size(); ++i) { placeholders << "?"; }
+    query.setForwardOnly(true);
+    query.prepare(QString(columns) + "WHERE code IN (" + placeholders.join(",") + ") ORDER BY rank IS NULL, rank, name");
+    for (QStringList::const_iterator iter = codes.begin(); iter != codes.end(); ++iter) {
+        query.addBindValue(*iter);
+    }
+    bool ok = query.exec();
+    if (!ok) { qDebug() << "selectCodes() failed" << query.lastError(); }
+    return ok;
+}
+
+//private slots:
+//a dropped favorite couldn't be written, favorites are shown again in the order they are in db
+void StopsQueryModel::onFavoriteMoved(const QString& code, bool ok) {
+    if (ok) return;
+    qDebug() << "Moving" << code << "failed";
+    showStops(Stop::Bus);
+}
+
+void StopsQueryModel::onStopsCleared(bool ok) {
+    if (!ok) { qDebug() << "clearing stopstable failed"; }
+    else qDebug() << "cleared stopstable";
+    showStops(Stop::Bus);
+}
+
+//searches are answered from the indexes of stops, a search that found nothing, ie: it was typed
+//before they were ready, is run again
+void StopsQueryModel::onStopsIndexed() {
+    if (!searchText.isEmpty() && rows.isEmpty()) { search(searchText); }
 }
 
 //public:
+//appends the stops with the given codes that are not shown yet, ie: search results as they are decoded
+void StopsQueryModel::addCodes(const QStringList& codes) {
+    QStringList missing;
+    for (QStringList::const_iterator iter = codes.begin(); iter != codes.end(); ++iter) {
+        if (indexOf(*iter) < 0 && !missing.contains(*iter)) { missing << *iter; }
+    }
+    QSqlQuery query(reader());
+    if (missing.isEmpty() || !selectCodes(query, missing)) return;
+    QVector<StopRow> added = read(query);
+    if (added.isEmpty()) return;
+    //new rows are only visible right away if every row has been fetched already
+    bool visible = fetched == rows.size();
+    if (visible) { beginInsertRows(QModelIndex(), rows.size(), rows.size() + added.size() - 1); }
+    rows << added;
+    if (visible) {
+        fetched = rows.size();
+        endInsertRows();
+    }
+    numberFavorites();
+}
+
+bool StopsQueryModel::canFetchMore(const QModelIndex& parent) const {
+    if (parent.isValid()) return false;
+    return fetched < rows.size();
+}
+
 QVariant StopsQueryModel::data(const QModelIndex& index, int role) const {
-    if(role <= Qt::UserRole)
-                return QSqlQueryModel::data(index, role);
-    QSqlRecord rec = record(index.row());
+    if (!index.isValid() || index.row() >= fetched) return QVariant();
+    const StopRow& stop = rows.at(index.row());
 
     switch (role) {
     case NameRole:
-        return rec.value("name").toString();
+        return stop.name;
     case CodeRole:
-        return rec.value("code");
+        return stop.code;
     case TypeRole:
-        return rec.value("type").toInt();
+        return stop.type;
     case TowardsRole:
-        return rec.value("towards");
+        return stop.towards;
     case LatitudeRole:
-        return rec.value("latitude").toDouble();
+        return stop.latitude;
     case LongitudeRole:
-        return rec.value("longitude").toDouble();
+        return stop.longitude;
     case StopPointIndicatorRole:
-        return rec.value("stoppointindicator");
+        return stop.stopPointIndicator;
     case RankRole:
-        return rec.value("rank");
+        //ranks have gaps, views show the place of the favorite
+        return stop.position ? QVariant(stop.position) : QVariant();
     default:
         return QVariant();
     }
 }
 
+//hands the next page of rows to views
+void StopsQueryModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) return;
+    int last = qMin(fetched + pageSize, rows.size()) - 1;
+    beginInsertRows(QModelIndex(), fetched, last);
+    fetched = last + 1;
+    endInsertRows();
+}
+
 QHash<int,QByteArray> StopsQueryModel::roleNames() const {
     QHash<int,QByteArray> roles;
     roles[NameRole] = "nameData";
@@ -80,38 +217,119 @@ QHash<int,QByteArray> StopsQueryModel::roleNames() const {
     return roles;
 }
 
+int StopsQueryModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid()) return 0;
+    return fetched;
+}
+
+//updates a stop that was made a favorite or stopped being one without querying every row again,
+//while favorites are listed it is inserted on the top or removed
+void StopsQueryModel::setFavorite(const QString& code, bool favorite) {
+    int row = indexOf(code);
+    QSqlQuery query(reader());
+    if (!selectCodes(query, QStringList() << code)) return;
+    QVector<StopRow> current = read(query);
+    if (current.isEmpty()) return;
+    const StopRow& stop = current.first();
+    bool listingFavorites = searchText.isEmpty();
+    if (row >= 0 && listingFavorites && !favorite) {
+        if (row < fetched) { beginRemoveRows(QModelIndex(), row, row); }
+        rows.remove(row);
+        if (row < fetched) {
+            --fetched;
+            endRemoveRows();
+        }
+    }
+    else if (row < 0 && listingFavorites && favorite && stop.type == Stop::Bus) {
+        //new favorites are ranked first
+        beginInsertRows(QModelIndex(), 0, 0);
+        rows.prepend(stop);
+        ++fetched;
+        endInsertRows();
+    }
+    else if (row >= 0) {
+        rows[row].rank = stop.rank;
+        if (row < fetched) { emit dataChanged(index(row), index(row)); }
+    }
+    numberFavorites();
+}
+
+//shows the stops with the given codes, favorites first
+void StopsQueryModel::showCodes(const QStringList& codes) {
+    QSqlQuery query(reader());
+    selectCodes(query, codes);
+    load(query);
+}
+
+//shows favorite stops, or the stops matching the search text if there is one
 void StopsQueryModel::showStops(int type) {
     qDebug() << "Showstops with type" << type;
-    setQuery("SELECT * FROM stopstable WHERE type = 1 ORDER BY rank");
-    if (type) {
-//        QString query = QString("SELECT * FROM stopstable WHERE type = ") + QString::number(type) + QString(" OR favorite = 1 ORDER BY rank");
-//        qDebug() << query;
-//        setQuery(query);
+    if (!searchText.isEmpty()) {
+        search(searchText);
+        return;
     }
-    else { setQuery("SELECT * FROM stopstable ORDER BY rank"); }
-
+    QSqlQuery query(reader());
+    query.setForwardOnly(true);
+    if (type) { query.exec(QString(columns) + "WHERE type = 1 AND favorite = 1 ORDER BY rank"); }
+    else { query.exec(QString(columns) + "ORDER BY rank"); }
+    load(query);
 }
 
 //public slots:
-//clears the database from stops from stopstable that are not set as favorite
+//shows favorites again, stops found so far are kept in db for later searches
+void StopsQueryModel::clearSearch() {
+    searchText.clear();
+    showStops(Stop::Bus);
+}
+
+//clears the database from stops from stopstable that are not set as favorite, stops are shown again by onStopsCleared()
 //this does//will not affect underground stations
 void StopsQueryModel::clearStops() {
-    if (databaseManager) {
-        bool ok = databaseManager->clearStopsTable();
-        if (!ok) { qDebug() << "clearing stopstable failed"; }
-        else qDebug() << "cleared stopstable";
-        showStops(Stop::Bus);
-    }
+    if (databaseManager && !databaseManager->clearStopsTable()) { qDebug() << "clearing stopstable failed"; }
 }
 
 QVariant StopsQueryModel::codeAt(int index) const {
-    return record(index).value("code");
+    if (index < 0 || index >= rows.size()) return QVariant();
+    return rows.at(index).code;
 }
 
+//moves a stop to the place of another one while favorites are dragged around, nothing is written to db
+//until saveMove() is called on drop, only the moved row is reported to views
 bool StopsQueryModel::move(int from, int to) {
-    qDebug() << "Moving index" << from << "to" << to;
     if (from == to) return true; //no move is required
-    bool ok = databaseManager->move(record(from).value("code").toString(), record(to).value("code").toString());
-    query().exec();
-    return ok;
+    if (from < 0 || to < 0 || from >= fetched || to >= fetched) return false;
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+    StopRow stop = rows.at(from);
+    rows.remove(from);
+    rows.insert(to, stop);
+    endMoveRows();
+    numberFavorites();
+    return true;
+}
+
+//writes the place of a favorite that was dragged from row from and dropped at row to with move() in the background,
+//only the rank of the dragged stop changes, the rows are put back if it can't be written, see onFavoriteMoved()
+bool StopsQueryModel::saveMove(int from, int to) {
+    qDebug() << "Moving index" << from << "to" << to;
+    if (from == to) return true;
+    if (from < 0 || to < 0 || from >= fetched || to >= fetched || !databaseManager) return false;
+    //the stop that was at to before the drag is next to the dragged one now
+    int replaced = to < from ? to + 1 : to - 1;
+    if (databaseManager->move(rows.at(to).code, rows.at(replaced).code)) { return true; }
+    move(to, from);
+    return false;
+}
+
+//shows the bus stops and piers in db matching text word by word as the user types, nothing is downloaded
+//returns false if there was no match
+bool StopsQueryModel::search(const QString& text) {
+    searchText = text.trimmed();
+    if (searchText.isEmpty()) {
+        showStops(Stop::Bus);
+        return true;
+    }
+    QStringList codes;
+    if (databaseManager) { codes = databaseManager->searchStops(searchText, QList<int>() << Stop::Bus << Stop::River); }
+    showCodes(codes);
+    return !codes.isEmpty();
 }
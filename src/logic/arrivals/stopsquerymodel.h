@@ -25,13 +25,19 @@ THE SOFTWARE.
 #ifndef STOPSQUERYMODEL_H
 #define STOPSQUERYMODEL_H
 
-#include <QSqlQueryModel>
+#include <QAbstractListModel>
+#include <QString>
+#include <QStringList>
+#include <QVector>
 
 class DatabaseManager;
+class QSqlDatabase;
+class QSqlQuery;
 
-//model to interact with sqlite database holding different stops
+//model of stops in the sqlite database, the rows of a query are read once into typed fields
+//and then updated in place, views get them a page at a time through fetchMore()
 // !!! Parent MUST be a pointer to DatabaseManager object !!!
-class StopsQueryModel : public QSqlQueryModel
+class StopsQueryModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_ENUMS(QueryTypes)
@@ -40,15 +46,49 @@ public:
                       LatitudeRole,LongitudeRole, StopPointIndicatorRole, RankRole };
     explicit StopsQueryModel(QObject* parent = 0);
 private:
+    struct StopRow {
+        QString code;
+        double latitude;
+        double longitude;
+        QString name;
+        int position;//place among favorites from 1, 0 if it is not a favorite
+        qint64 rank;//0 if it is not a favorite
+        QString stopPointIndicator;
+        QString towards;
+        int type;
+    };
     DatabaseManager* databaseManager;
+    int fetched;//rows handed to views so far
+    QVector<StopRow> rows;//every row of the last query
+    QString searchText;//stops matching it are shown instead of favorites while it is not empty
+private:
+    int indexOf(const QString& code) const;
+    void load(QSqlQuery&);
+    void numberFavorites();
+    QVector<StopRow> read(QSqlQuery&) const;
+    QSqlDatabase reader() const;
+    bool selectCodes(QSqlQuery&, const QStringList& codes) const;
+private slots:
+    void onFavoriteMoved(const QString& code, bool ok);
+    void onStopsCleared(bool ok);
+    void onStopsIndexed();
 public:
+    void addCodes(const QStringList& codes);
+    virtual bool canFetchMore(const QModelIndex& parent) const;
     virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    virtual void fetchMore(const QModelIndex& parent);
     virtual QHash<int,QByteArray> roleNames() const;
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    void setFavorite(const QString& code, bool);
+    void showCodes(const QStringList& codes);
     Q_INVOKABLE void showStops(int type);
 public slots:
+    void clearSearch();
     void clearStops();
     QVariant codeAt(int index) const;
     bool move(int from, int to);
+    bool saveMove(int from, int to);
+    bool search(const QString& text);
 };
 
 
@@ -0,0 +1,259 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "urareader.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QJsonValue>
+#include <QSettings>
+#include "../network/managedreply.h"
+
+namespace {
+//the order in which the server sends the fields of each kind of array, see Bus arrivals API documentation
+const char* const stopOrder[] = { "StopPointName", "StopID", "StopCode1", "StopCode2", "StopPointType", "Towards",
+                                  "Bearing", "StopPointIndicator", "StopPointState", "Latitude", "Longitude", 0 };
+const char* const predictionOrder[] = { "VisitNumber", "LineID", "LineName", "DirectionID", "DestinationText",
+                                        "DestinationName", "VehicleID", "TripID", "RegistrationNumber",
+                                        "EstimatedTime", "ExpireTime", 0 };
+const char* const messageOrder[] = { "MessageUUID", "MessageType", "MessagePriority", "MessageText",
+                                     "StartTime", "ExpireTime", 0 };
+
+QStringList toList(const char* const names[]) {
+    QStringList list;
+    for (int i = 0; names[i]; ++i) { list << QString(names[i]); }
+    return list;
+}
+
+//returns the value of a field or an undefined value if the field was not requested or the array is too short
+QJsonValue valueOf(const QJsonArray& array, const QHash<QString,int>& fields, const char* name) {
+    int index = fields.value(QString(name), -1);
+    if (index < 0 || index >= array.size()) { return QJsonValue(QJsonValue::Undefined); }
+    return array.at(index);
+}
+}//end of unnamed namespace
+
+UraReader::UraReader(const QStringList& list, QObject* parent) : QObject(parent),
+                                                                 clockOffset(0),
+                                                                 error(false),
+                                                                 reply(0),
+                                                                 returnList(list),
+                                                                 serverTime(0),
+                                                                 stopDetails(false)
+{
+    //element 0 is always the ResponseType, stop fields come first in every kind of array
+    int position = 1;
+    indexFields(toList(stopOrder), stopFields, position);
+    int predictionPosition = position;
+    predictionFields = stopFields;
+    indexFields(toList(predictionOrder), predictionFields, predictionPosition);
+    int messagePosition = position;
+    messageFields = stopFields;
+    indexFields(toList(messageOrder), messageFields, messagePosition);
+
+    QStringList details = QStringList() << "StopCode2" << "StopPointType" << "Towards" << "Bearing"
+                                        << "StopPointIndicator" << "StopPointState" << "Latitude" << "Longitude";
+    for (QStringList::const_iterator iter = details.begin(); iter != details.end(); ++iter) {
+        if (returnList.contains(*iter)) { stopDetails = true; }
+    }
+}
+
+//private:
+//stop fields are at the same position in every kind of array, so the stop part of a prediction or
+//message array is decoded like a stop array
+void UraReader::decodeEmbeddedStop(const QJsonArray& array) {
+    if (!stopDetails) return;
+    QString key = valueOf(array, stopFields, "StopCode1").toString() + "|" + valueOf(array, stopFields, "StopPointName").toString();
+    if (embeddedStops.contains(key)) return;
+    embeddedStops.insert(key);
+    decodeStop(array);
+}
+
+//decodes a single line and emits the matching typed record
+void UraReader::decodeLine(const QByteArray& line) {
+    if (line.trimmed().isEmpty()) return;
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isArray()) {
+        qDebug() << "Invalid URA line:" << parseError.errorString();
+        return;
+    }
+    QJsonArray array = document.array();
+    if (array.isEmpty()) return;
+    switch (array.at(0).toInt(-1)) {
+    case StopRecord:
+        decodeStop(array);
+        return;
+    case PredictionRecord:
+        decodeEmbeddedStop(array);
+        decodePrediction(array);
+        return;
+    case MessageRecord:
+        decodeEmbeddedStop(array);
+        decodeMessage(array);
+        return;
+    case VersionRecord:
+        //server time UTC in msec from Epoch at the time of request
+        if (array.size() > 2) {
+            serverTime = array.at(2).toDouble();
+            //measured when the reply arrives, so it is off by the latency at most
+            clockOffset = serverTime - QDateTime::currentMSecsSinceEpoch();
+            emit versionDecoded(serverTime);
+        }
+        return;
+    default:
+        return;
+    }
+}
+
+void UraReader::decodeMessage(const QJsonArray& array) {
+    UraMessage message;
+    message.stopCode = valueOf(array, messageFields, "StopCode1").toString();
+    message.priority = valueOf(array, messageFields, "MessagePriority").toDouble();
+    message.text = valueOf(array, messageFields, "MessageText").toString();
+    message.startTime = valueOf(array, messageFields, "StartTime").toDouble();
+    message.expireTime = valueOf(array, messageFields, "ExpireTime").toDouble();
+    emit messageDecoded(message);
+}
+
+void UraReader::decodePrediction(const QJsonArray& array) {
+    UraPrediction prediction;
+    prediction.stopCode = valueOf(array, predictionFields, "StopCode1").toString();
+    prediction.stopName = valueOf(array, predictionFields, "StopPointName").toString();
+    prediction.line = valueOf(array, predictionFields, "LineName").toString();
+    QJsonValue direction = valueOf(array, predictionFields, "DirectionID");
+    if (!direction.isUndefined()) { prediction.directionId = QString::number(direction.toDouble()); }
+    prediction.destination = valueOf(array, predictionFields, "DestinationName").toString();
+    prediction.registration = valueOf(array, predictionFields, "RegistrationNumber").toString();
+    prediction.estimatedTime = valueOf(array, predictionFields, "EstimatedTime").toDouble();
+    prediction.expireTime = valueOf(array, predictionFields, "ExpireTime").toDouble();
+    emit predictionDecoded(prediction);
+}
+
+void UraReader::decodeStop(const QJsonArray& array) {
+    UraStop stop;
+    stop.name = valueOf(array, stopFields, "StopPointName").toString();
+    //null for a few stops ie: Hammersmith Bus Station, it is left as an empty string
+    stop.code = valueOf(array, stopFields, "StopCode1").toString();
+    stop.type = valueOf(array, stopFields, "StopPointType").toString();
+    stop.towards = valueOf(array, stopFields, "Towards").toString();
+    stop.indicator = valueOf(array, stopFields, "StopPointIndicator").toString();
+    stop.latitude = valueOf(array, stopFields, "Latitude").toDouble();
+    stop.longitude = valueOf(array, stopFields, "Longitude").toDouble();
+    emit stopDecoded(stop);
+}
+
+//decodes every complete line in the buffer, if all is true the remaining incomplete line too
+void UraReader::decodeBuffer(bool all) {
+    int start = 0;
+    int end;
+    while ((end = buffer.indexOf('\n', start)) != -1) {
+        decodeLine(buffer.mid(start, end - start));
+        start = end + 1;
+    }
+    buffer.remove(0, start);
+    if (all) {
+        decodeLine(buffer);
+        buffer.clear();
+    }
+}
+
+//assigns the next position to each field of canonicalOrder that was requested
+void UraReader::indexFields(const QStringList& canonicalOrder, QHash<QString,int>& fields, int& position) const {
+    for (QStringList::const_iterator iter = canonicalOrder.begin(); iter != canonicalOrder.end(); ++iter) {
+        if (returnList.contains(*iter)) { fields.insert(*iter, position++); }
+    }
+}
+
+//public:
+//stops reading and throws away the reply being read, no more signals are emitted for it
+void UraReader::abort() {
+    if (reply) {
+        disconnect(reply, 0, this, 0);
+        reply->abort();
+        reply->deleteLater();
+        reply = 0;
+    }
+    buffer.clear();
+}
+
+//difference between server clock and device clock in msec measured with the last reply,
+//adding it to device time gives server time even if the device clock is not correctly set
+double UraReader::getClockOffset() const { return clockOffset; }
+
+//returns the ReturnList parameter to be appended to a request
+QString UraReader::getReturnList() const { return QString("&ReturnList=") + returnList.join(","); }
+
+//server time of the last reply in msec from Epoch, 0 until the version array is decoded
+double UraReader::getServerTime() const { return serverTime; }
+
+//returns the address of the URA interfaces, instant_V1 and stream_V1 are found under it
+//it can be pointed to a local server that replays recorded replies by setting ura/server in the settings file
+QString UraReader::getServerUrl() {
+    return QSettings().value("ura/server", "http://countdown.api.tfl.gov.uk/interfaces/ura/").toString();
+}
+
+//returns true if the last reply finished with a network error
+bool UraReader::hasError() const { return error; }
+
+bool UraReader::isReading() const { return reply != 0; }
+
+//starts reading a reply, a reply that is still being read is aborted as it has been superseded
+//reply is deleted by UraReader when it is finished
+void UraReader::read(ManagedReply* r) {
+    abort();
+    embeddedStops.clear();
+    error = false;
+    serverTime = 0;
+    reply = r;
+    if (!reply) return;
+    connect(reply, SIGNAL(readyRead()), this, SLOT(onReadyRead()) );
+    connect(reply, SIGNAL(finished()), this, SLOT(onFinished()) );
+}
+
+//private slots:
+void UraReader::onFinished() {
+    if (!reply) return;
+    ManagedReply* finishedReply = reply;
+    if (finishedReply->error() != QNetworkReply::NoError) {
+        error = true;
+        qDebug() << "URA request failed:" << finishedReply->errorString();
+    }
+    buffer += finishedReply->readAll();
+    decodeBuffer(true);
+    reply = 0;
+    finishedReply->deleteLater();
+    emit chunkDecoded();
+    emit finished();
+}
+
+//decodes lines that have arrived so far
+void UraReader::onReadyRead() {
+    if (!reply) return;
+    buffer += reply->readAll();
+    decodeBuffer(false);
+    emit chunkDecoded();
+}
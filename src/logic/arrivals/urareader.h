@@ -0,0 +1,91 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef URAREADER_H
+#define URAREADER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include "urarecords.h"
+
+class ManagedReply;
+class QJsonArray;
+
+//Incremental decoder for the line delimited JSON replies of Countdown (URA),
+//lines are decoded as soon as they arrive and handed out as typed records
+//Position of each field is worked out from the ReturnList as the server always sends
+//the requested fields in the same order regardless of the order they were requested in
+//If stop details are requested along with predictions or messages the server only sends them as part of
+//those arrays, they are handed out with stopDecoded() too, once for each stop of a reply
+class UraReader : public QObject
+{
+    Q_OBJECT
+public:
+    enum RecordType { StopRecord, PredictionRecord, MessageRecord, BaseVersionRecord, VersionRecord };
+    explicit UraReader(const QStringList& returnList, QObject* parent = 0);
+private:
+    QByteArray buffer;//holds an incomplete line until the rest of it arrives
+    double clockOffset;//server clock - device clock in msec
+    QSet<QString> embeddedStops;//stops already handed out from prediction or message arrays of this reply
+    bool error;
+    QHash<QString,int> messageFields;
+    QHash<QString,int> predictionFields;
+    ManagedReply* reply;
+    QStringList returnList;
+    double serverTime;
+    bool stopDetails;//stop fields other than name and code were requested
+    QHash<QString,int> stopFields;
+private:
+    void decodeEmbeddedStop(const QJsonArray&);
+    void decodeLine(const QByteArray& line);
+    void decodeMessage(const QJsonArray&);
+    void decodePrediction(const QJsonArray&);
+    void decodeStop(const QJsonArray&);
+    void decodeBuffer(bool all);
+    void indexFields(const QStringList& canonicalOrder, QHash<QString,int>& fields, int& position) const;
+public:
+    void abort();
+    double getClockOffset() const;
+    QString getReturnList() const;
+    double getServerTime() const;
+    static QString getServerUrl();
+    bool hasError() const;
+    bool isReading() const;
+    void read(ManagedReply*);
+signals:
+    void chunkDecoded();
+    void finished();
+    void messageDecoded(const UraMessage&);
+    void predictionDecoded(const UraPrediction&);
+    void stopDecoded(const UraStop&);
+    void versionDecoded(double serverTime);
+private slots:
+    void onFinished();
+    void onReadyRead();
+};
+
+#endif // URAREADER_H
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef URARECORDS_H
+#define URARECORDS_H
+
+#include <QString>
+
+//Typed records of a Countdown (URA) reply, fields that were not requested in the ReturnList keep their default value
+
+//stop array, ResponseType 0
+struct UraStop
+{
+    UraStop();
+    QString code;//StopCode1
+    QString indicator;//StopPointIndicator
+    double latitude;
+    double longitude;
+    QString name;//StopPointName
+    QString towards;
+    QString type;//StopPointType
+};
+
+//prediction array, ResponseType 1, it is either a vehicle at a stop or a point of a journey
+struct UraPrediction
+{
+    UraPrediction();
+    QString destination;//DestinationName
+    QString directionId;
+    double estimatedTime;//UTC msec from epoch
+    double expireTime;//UTC msec from epoch
+    QString line;//LineName
+    QString registration;//RegistrationNumber
+    QString stopCode;//StopCode1
+    QString stopName;//StopPointName
+};
+
+//flexible message array, ResponseType 2
+struct UraMessage
+{
+    UraMessage();
+    double expireTime;//UTC msec from epoch
+    int priority;
+    double startTime;//UTC msec from epoch
+    QString stopCode;//StopCode1
+    QString text;
+};
+
+#endif // URARECORDS_H
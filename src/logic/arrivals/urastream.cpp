@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "urastream.h"
+#include <QDebug>
+#include <QTimer>
+#include <QUrl>
+#include "../network/requestmanager.h"
+#include "urareader.h"
+
+namespace {
+const int firstRetryDelay = 30000;//30 sec
+const int maxRetryDelay = 600000;//10 min
+const int silenceTimeout = 120000;//2 min
+}//end of unnamed namespace
+
+UraStream::UraStream(RequestManager* mngr, const QStringList& returnList, const QString& ch, QObject* parent) : QObject(parent),
+                                                    channel(ch),
+                                                    live(false),
+                                                    reader(new UraReader(returnList, this)),
+                                                    requestManager(mngr),
+                                                    retryDelay(firstRetryDelay),
+                                                    retryTimer(new QTimer(this)),
+                                                    running(false),
+                                                    watchdog(new QTimer(this))
+{
+    retryTimer->setSingleShot(true);
+    watchdog->setSingleShot(true);
+    connect(reader, SIGNAL(chunkDecoded()), this, SLOT(onChunkDecoded()) );
+    connect(reader, SIGNAL(finished()), this, SLOT(onFinished()) );
+    connect(retryTimer, SIGNAL(timeout()), this, SLOT(connectStream()) );
+    connect(watchdog, SIGNAL(timeout()), this, SLOT(onSilence()) );
+}
+
+//private:
+//reports the stream broken and schedules a reconnection, every failure in a row doubles the delay
+void UraStream::breakDown() {
+    watchdog->stop();
+    live = false;
+    emit broken();
+    if (!running) return;
+    retryTimer->start(retryDelay);
+    retryDelay = qMin(retryDelay * 2, maxRetryDelay);
+}
+
+//public:
+UraReader* UraStream::getReader() { return reader; }
+
+//returns true if the stream is connected and delivering data
+bool UraStream::isLive() const { return live; }
+
+//returns true between start() and stop() even if the stream is broken at the moment
+bool UraStream::isRunning() const { return running; }
+
+//starts streaming predictions matching the query ie: "StopCode1=52334"
+void UraStream::start(const QString& q) {
+    if (running && q == query) return;
+    query = q;
+    running = true;
+    retryDelay = firstRetryDelay;
+    connectStream();
+}
+
+//closes the stream, no more signals are emitted
+void UraStream::stop() {
+    running = false;
+    live = false;
+    retryTimer->stop();
+    watchdog->stop();
+    reader->abort();
+}
+
+//private slots:
+void UraStream::connectStream() {
+    if (!running || !requestManager) return;
+    live = false;
+    QUrl url(UraReader::getServerUrl() + "stream_V1?" + query + reader->getReturnList());
+    reader->read(requestManager->stream(url, channel));
+    watchdog->start(silenceTimeout);
+}
+
+//the last chunk of a closed stream does not count as the stream being alive
+void UraStream::onChunkDecoded() {
+    if (!running || !reader->isReading()) return;
+    watchdog->start(silenceTimeout);
+    if (!live) {
+        live = true;
+        retryDelay = firstRetryDelay;
+        emit established();
+    }
+}
+
+//the server closed the stream or the connection failed
+void UraStream::onFinished() {
+    if (!running) return;
+    qDebug() << "URA stream closed" << (reader->hasError() ? "with error" : "");
+    breakDown();
+}
+
+//nothing arrived for too long, the connection is probably dead without having noticed it
+void UraStream::onSilence() {
+    if (!running) return;
+    qDebug() << "URA stream went silent";
+    reader->abort();
+    breakDown();
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef URASTREAM_H
+#define URASTREAM_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QTimer;
+class RequestManager;
+class UraReader;
+
+//Keeps a connection open to the streaming interface of Countdown (URA), the predictions pushed
+//through it are decoded by the reader returned by getReader()
+//A stream that ends, fails or stays silent for too long is reported broken and reconnected later
+//with an increasing delay, established() is emitted whenever data starts flowing again
+class UraStream : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UraStream(RequestManager*, const QStringList& returnList, const QString& channel, QObject* parent = 0);
+private:
+    QString channel;
+    bool live;//data has arrived since the last (re)connection
+    QString query;
+    UraReader* reader;
+    RequestManager* requestManager;
+    int retryDelay;//msec
+    QTimer* retryTimer;
+    bool running;
+    QTimer* watchdog;
+private:
+    void breakDown();
+public:
+    UraReader* getReader();
+    bool isLive() const;
+    bool isRunning() const;
+    void start(const QString& query);
+    void stop();
+signals:
+    void broken();
+    void established();
+private slots:
+    void connectStream();
+    void onChunkDecoded();
+    void onFinished();
+    void onSilence();
+};
+
+#endif // URASTREAM_H
@@ -23,7 +23,34 @@ THE SOFTWARE.
 */
 
 #include "vehicle.h"
+#include <QDateTime>
 #include <QString>
+#include <cmath>
 
-Vehicle::Vehicle() : eta(9999) {
+Vehicle::Vehicle() : clockOffset(0), estimatedTime(0), eta(9999), type(Bus) {
+}
+
+//eta and clock offset are derived values, they are not compared
+bool Vehicle::operator==(const Vehicle& rhs) const {
+    return id == rhs.id && line == rhs.line && destination == rhs.destination &&
+           direction == rhs.direction && estimatedTime == rhs.estimatedTime &&
+           towards == rhs.towards && platform == rhs.platform && type == rhs.type;
+}
+
+bool Vehicle::operator!=(const Vehicle& rhs) const { return !(*this == rhs); }
+
+//identifies the same vehicle across updates, a registration number alone is not enough
+//as the same bus might be working on a different line later on
+QString Vehicle::getKey() const { return id + QChar('|') + line; }
+
+//works out eta from the predicted time and the current time on the server clock,
+//returns true if eta has changed since the last call
+bool Vehicle::updateEta() {
+    if (!estimatedTime) return false;//no prediction
+    double now = QDateTime::currentMSecsSinceEpoch() + clockOffset;
+    //round to whole minutes
+    int newEta = std::round((estimatedTime - now) / 1000 / 60);
+    if (newEta == eta) return false;
+    eta = newEta;
+    return true;
 }
@@ -32,10 +32,17 @@ struct Vehicle
 {
     enum Type { Boat, Bus, Dlr, OverGround, UnderGround };
     Vehicle();
+    bool operator==(const Vehicle&) const;
+    bool operator!=(const Vehicle&) const;
+    QString getKey() const;
+    bool updateEta();
     QString id;//for bus it's the registration number
     QString line;
     QString destination;
-    int eta; //in minutes
+    QString direction;//DirectionID of a bus, journey progress is asked with it
+    double clockOffset;//server clock - device clock in msec when the prediction was received
+    double estimatedTime;//predicted arrival UTC msec from epoch on server clock
+    int eta; //in minutes, as last worked out by updateEta()
     QString towards;
     QString platform;
     int type;
@@ -24,72 +24,124 @@ THE SOFTWARE.
 
 
 #include "arrivalslogic.h"
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
-#include <QJsonArray>
-#include <QJsonDocument>
+#include <QFileInfo>
 #include <QList>
 #include <QMultiMap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QSettings>
 #include <QStandardPaths>
 #include <QStringListModel>
 #include <QTimer>
 #include <QUrl>
-#include <cmath>
-#include "arrivals/arrivalsmodel.h"
 #include "arrivals/arrivalsproxymodel.h"
-#include "arrivals/arrivalscontainer.h"
 #include "arrivals/journeyprogresscontainer.h"
+#include "arrivals/multistoparrivals.h"
 #include "arrivals/stop.h"
 #include "arrivals/stopsquerymodel.h"
+#include "arrivals/urareader.h"
+#include "arrivals/urastream.h"
 #include "arrivals/vehicle.h"
+#include "coverlogic.h"
 #include "database/databasemanager.h"
+#include "network/managedreply.h"
+#include "network/requestmanager.h"
 
 ArrivalsLogic::ArrivalsLogic(DatabaseManager* dbm, QObject* parent) : QObject(parent),
                                                 activeStops("StopPointState=0"),
-                                                arrivalsContainer(new ArrivalsContainer()),
-                                                arrivalsModel(new ArrivalsModel(arrivalsContainer,this)),
-                                                arrivalsProxyModel(new ArrivalsProxyModel(this)),
-                                                arrivalsTimer(new QTimer(this)),
-                                                baseUrl("http://countdown.api.tfl.gov.uk/interfaces/ura/instant_V1?"),
+                                                baseUrl(UraReader::getServerUrl() + "instant_V1?"),
+                                                busStopReader(new UraReader(QStringList() << "StopPointName" << "Towards" << "StopPointIndicator"
+                                                                                          << "StopPointType" << "Latitude" << "Longitude", this)),
+                                                coverLogic(0),
                                                 databaseManager(dbm),
-                                                currentStop(new Stop(databaseManager)),
                                                 displayTimer(new QTimer(this)),
-                                                downloadingArrivals(false),
                                                 downloadingJourneyProgress(false),
                                                 downloadingListOfStops(false),
                                                 downloadingStop(false),
-                                                networkMngr(static_cast<QNetworkAccessManager*>(parent)),
+                                                importProgress(0),
                                                 journeyProgressContainer(new JourneyProgressContainer(this)),
+                                                journeyProgressReader(new UraReader(QStringList() << "StopPointName" << "EstimatedTime", this)),
+                                                journeyProgressStream(new UraStream(static_cast<RequestManager*>(parent),
+                                                                                    QStringList() << "StopPointName" << "EstimatedTime",
+                                                                                    "journeyProgressStream", this)),
                                                 journeyProgressTimer(new QTimer(this)),
-                                                reply_arrivals(0),
-                                                reply_busStop(0),
-                                                reply_busStopMessage(0),
-                                                reply_journeyProgress(0),
                                                 reply_stations(0),
-                                                reply_stops(0),
-                                                stopsQueryModel(new StopsQueryModel(databaseManager))
+                                                requestManager(static_cast<RequestManager*>(parent)),
+                                                stopArrivals(new MultiStopArrivals(static_cast<RequestManager*>(parent), databaseManager, this)),
+                                                stopDetailsReceived(false),
+                                                stopPageReader(new UraReader(QStringList() << "StopPointName" << "Towards" << "StopPointIndicator"
+                                                                                           << "StopPointType" << "Latitude" << "Longitude"
+                                                                                           << "MessagePriority" << "MessageText"
+                                                                                           << "StartTime" << "ExpireTime", this)),
+                                                stopsQueryModel(new StopsQueryModel(databaseManager)),
+                                                stopsReader(new UraReader(QStringList() << "StopPointName" << "StopCode1" << "Towards" << "StopPointIndicator"
+                                                                                        << "StopPointType" << "Latitude" << "Longitude", this)),
+                                                streaming(QSettings().value("ura/streaming", false).toBool()),
+                                                updatingFavorites(false),
+                                                updatingJourneyProgress(false)
 {
-    arrivalsProxyModel->setSourceModel(arrivalsModel);
-    arrivalsProxyModel->sort(0);
+    stopArrivals->setStreamingEnabled(streaming);
     stopsQueryModel->showStops(Stop::Bus);
 
-    connect(arrivalsTimer, SIGNAL(timeout()), this, SLOT(fetchArrivalsData()) );
     connect(journeyProgressTimer, SIGNAL(timeout()), this, SLOT(fetchJourneyProgress()) );
     connect(journeyProgressContainer, SIGNAL(dataChanged()), this, SLOT(onProgressDataChanged()) );
     connect(displayTimer, SIGNAL(timeout()), this, SLOT(onDisplayTimerTicked()) );
+    connect(stopArrivals, SIGNAL(dataChanged()), this, SIGNAL(favoriteArrivalsChanged()) );
+    connect(stopArrivals, SIGNAL(downloadStateChanged()), this, SIGNAL(downloadStateChanged()) );
+    if (databaseManager) {
+        connect(databaseManager, SIGNAL(favoriteChanged(QString,bool)), this, SLOT(onFavoriteChanged(QString,bool)) );
+        connect(databaseManager, SIGNAL(favoritesChanged()), this, SIGNAL(favoritesChanged()) );
+        connect(databaseManager, SIGNAL(importProgressChanged(int)), this, SLOT(onImportProgressChanged(int)) );
+        connect(databaseManager, SIGNAL(stopsAdded(QStringList)), this, SLOT(onStopsAdded(QStringList)) );
+        connect(databaseManager, SIGNAL(stopsImported(bool)), this, SLOT(onStopsImported(bool)) );
+    }
+
+    connect(busStopReader, SIGNAL(stopDecoded(UraStop)), this, SLOT(onBusStopDecoded(UraStop)) );
+    connect(busStopReader, SIGNAL(finished()), this, SLOT(onBusStopDataReceived()) );
+    connect(journeyProgressReader, SIGNAL(predictionDecoded(UraPrediction)), this, SLOT(onJourneyPointDecoded(UraPrediction)) );
+    connect(journeyProgressReader, SIGNAL(chunkDecoded()), this, SLOT(onBusProgressDecoded()) );
+    connect(journeyProgressReader, SIGNAL(finished()), this, SLOT(onBusProgressReceived()) );
+    connect(stopsReader, SIGNAL(stopDecoded(UraStop)), this, SLOT(onListedStopDecoded(UraStop)) );
+    connect(stopsReader, SIGNAL(finished()), this, SLOT(onListOfBusStopsReceived()) );
+    connect(stopPageReader, SIGNAL(stopDecoded(UraStop)), this, SLOT(onBusStopDecoded(UraStop)) );
+    connect(stopPageReader, SIGNAL(messageDecoded(UraMessage)), this, SLOT(onStopPageMessageDecoded(UraMessage)) );
+    connect(stopPageReader, SIGNAL(finished()), this, SLOT(onStopPageDataReceived()) );
+
+    connect(journeyProgressStream->getReader(), SIGNAL(predictionDecoded(UraPrediction)), this, SLOT(onStreamedJourneyPointDecoded(UraPrediction)) );
+    connect(journeyProgressStream->getReader(), SIGNAL(chunkDecoded()), this, SLOT(onJourneyProgressStreamDecoded()) );
+    connect(journeyProgressStream, SIGNAL(broken()), this, SLOT(onJourneyProgressStreamStateChanged()) );
+    connect(journeyProgressStream, SIGNAL(established()), this, SLOT(onJourneyProgressStreamStateChanged()) );
+}
+
+//sets the object that reports what is on display, polling is adjusted to it
+void ArrivalsLogic::setCoverLogic(CoverLogic* logic) {
+    coverLogic = logic;
+    if (coverLogic) {
+        connect(coverLogic, SIGNAL(visibilityChanged()), this, SLOT(onVisibilityChanged()) );
+        onVisibilityChanged();
+    }
 }
 
 //private:
 
-//clears the container holding the vehicles and their predicted eta
-//the container notifies the model which notifies connected views
-void ArrivalsLogic::clearArrivalsData() {
-    if (arrivalsContainer) {
-        arrivalsContainer->clearData();
+//keeps a message if it is currently active
+void ArrivalsLogic::addMessage(const UraMessage& message, const UraReader* reader) {
+    double serverTime = reader->getServerTime();
+    if (message.startTime <= serverTime && message.expireTime >= serverTime) {
+        pendingMessages.insert(message.priority, message.text);
+    }
+}
+
+//moves decoded journey points to the container, stops are displayed before the download finishes
+void ArrivalsLogic::applyProgress(QList<QPair<QString,double> >& pending, const UraReader* reader) {
+    if (pending.isEmpty() || !reader->getServerTime()) { return; } //nothing to do
+    if (journeyProgressContainer) {
+        journeyProgressContainer->setClockOffset(reader->getClockOffset());
+        journeyProgressScheduler.recordChange(journeyProgressContainer->refreshData(pending));
     }
+    pending.clear();
 }
 
 //clears jorneyprogress data container takes care of notifying model,views
@@ -105,7 +157,7 @@ void ArrivalsLogic::downloadStations() {
     if (!file.exists()) {
         QString link = "https://github.com/KrisztianOlah/london-sail/raw/devel/stations.csv";
         QUrl url(link);
-        reply_stations = networkMngr->get(QNetworkRequest(url));
+        reply_stations = requestManager->get(url, RequestManager::Background, "stations");
 
         connect(reply_stations,SIGNAL(finished()), this, SLOT(onStationsDownloaded()) );
     }
@@ -115,78 +167,90 @@ void ArrivalsLogic::downloadStations() {
     }
 }
 
-void ArrivalsLogic::fillCurrentStopMessages(const QMap<int,QString>& map) {
+//asks for the details and messages of the next opened stop with a single query,
+//stops are asked one after the other as a new query would abort the one under way
+void ArrivalsLogic::fetchStopPage() {
+    if (!readingStop.isEmpty() || queuedStops.isEmpty()) return;
+    readingStop = queuedStops.takeFirst();
+    QString request = baseUrl + QString("StopCode1=") + readingStop + stopPageReader->getReturnList();
+    QUrl url(request);
+    downloadingStop = true;
+    emit downloadStateChanged();
+    stopDetailsReceived = false;
+    pendingMessages.clear();
+    stopPageReader->read(requestManager->get(url, RequestManager::Foreground, "stopPage"));
+}
+
+//the details and messages of readingStop are in every page of it, the next opened stop is asked for
+void ArrivalsLogic::finishStopPage() {
+    readingStop.clear();
+    downloadingStop = false;
+    emit downloadStateChanged();
+    fetchStopPage();
+}
+
+//imports stops.csv in the background if it was put in the data directory or changed since the last import,
+//so that stop details don't need to be downloaded one search at a time, see onStopsImported()
+void ArrivalsLogic::importStops() {
+    QFileInfo info(QStandardPaths::writableLocation(QStandardPaths::DataLocation) + QString("/stops.csv"));
+    if (!info.exists()) return;
+    QDateTime imported = QSettings().value("stops/imported").toDateTime();
+    if (imported.isValid() && imported >= info.lastModified()) return;
+    if (pendingImport == info.lastModified()) return; //already queued
+    bool ok = databaseManager->importStops(info.filePath());
+    if (!ok) qDebug() << "Import Failed";
+    else pendingImport = info.lastModified();
+}
+
+//joins the messages of a stop in the order of their priority
+QString ArrivalsLogic::formatMessages(const QMap<int,QString>& map) const {
+    QString messages;
     //there are 5 priorities at the moment, it may change to 6 in the near future and up to 10 in the far future
     for (int index = 0; index != 6; ++index) {
         QList<QString> listOfMessages = map.values(index);
         for (QList<QString>::const_iterator iter = listOfMessages.begin();iter < listOfMessages.end(); ++iter) {
-            currentStopMessages.append(" * ");
-            currentStopMessages.append(*iter);
+            messages.append(" * ");
+            messages.append(*iter);
         }
     }
-    emit currentStopMessagesChanged();
+    return messages;
 }
 
-//FIX registration num must not start with X_or contain NEW in the first five letters
-//downloads the data required for bus and river bus arrivals
-void ArrivalsLogic::getBusArrivalsByCode(const QString& code) {
-    QString stopCode = QString("StopCode1=") + code;
-    QString returnList = "&ReturnList=LineName,DestinationName,EstimatedTime,RegistrationNumber,DirectionID";
-    QString request = baseUrl + stopCode +  returnList;
-
+//downloads bus stop data for a bus stop with a given code
+void ArrivalsLogic::getBusStopByCode(const QString& code) {
+    QString stopcode = QString("StopCode1=") + code;
+    QString request = baseUrl + stopcode + busStopReader->getReturnList();
     QUrl url(request);
-    downloadingArrivals = true;
-    emit downloadStateChanged();
-    reply_arrivals = networkMngr->get(QNetworkRequest(url));
-
-    connect(reply_arrivals, SIGNAL(finished()), this, SLOT(onArrivalsDataReceived()) );
+    busStopReader->read(requestManager->get(url, RequestManager::Foreground, "busStop"));
 }
 
 //downloads data required for bus journey progress
 void ArrivalsLogic::getBusProgress(const QString& registrationNum) {
     QString regPart = QString("RegistrationNumber=") + registrationNum;
-    QString directionIDPart = QString("&DirectionID=") + currentBusDirectionId;
-    QString returnList = "&ReturnList=StopPointName,EstimatedTime";
-    QString request = baseUrl + regPart + directionIDPart + returnList;
+    //a bus that is only known from the saved arrivals has no direction
+    QString directionIDPart = currentBusDirectionId.isEmpty() ? QString() : QString("&DirectionID=") + currentBusDirectionId;
+    QString request = baseUrl + regPart + directionIDPart + journeyProgressReader->getReturnList();
     QUrl url(request);
     downloadingJourneyProgress = true;
     emit downloadStateChanged();
-    reply_journeyProgress = networkMngr->get(QNetworkRequest(url));
-
-    connect(reply_journeyProgress, SIGNAL(finished()), this, SLOT(onBusProgressReceived()) );
+    pendingProgress.clear();
+    journeyProgressReader->read(requestManager->get(url, RequestManager::Foreground, "journeyProgress"));
 }
 
-//creates a list of QJsonDocument arrays from a QNetworkReply so long the format is Json
-QList<QJsonDocument> ArrivalsLogic::makeDocument(QNetworkReply* reply) {
-    QList<QJsonDocument> document;
-    if (reply) {
-        while (!reply->atEnd()) {
-            document << QJsonDocument::fromJson(reply->readLine());
-        }
-        reply->deleteLater();
+//restarts the timer so that next download is scheduled according to the next stop and visibility
+//if streaming is enabled and journey progress is visible the stream is used instead, polling only continues until
+//the stream delivers data or while it is broken
+void ArrivalsLogic::scheduleJourneyProgress() {
+    if (coverLogic) { journeyProgressScheduler.setVisibility(coverLogic->getVisibility(CoverLogic::JourneyProgressPage)); }
+    if (streaming && currentVehicleId != "" && journeyProgressScheduler.getVisibility() != PollScheduler::Hidden) {
+        journeyProgressStream->start(QString("RegistrationNumber=") + currentVehicleId + QString("&DirectionID=") + currentBusDirectionId);
     }
-    return document;
+    else { journeyProgressStream->stop(); }
+    if (journeyProgressStream->isLive()) { journeyProgressTimer->stop(); }
+    else { journeyProgressTimer->start(journeyProgressScheduler.nextInterval(journeyProgressContainer->getSecondsToNextStop())); }
 }
 
 //private slots:
-//calls the correct function chain for each kind of Stop to download and process arrivals data such as eta
-void ArrivalsLogic::fetchArrivalsData() {
-    qDebug() << "updated";
-    if (currentStop) {
-        switch (currentStop->getType()) {
-        case Stop::None:
-            return;
-        case Stop::Bus:
-            getBusArrivalsByCode(currentStop->getID());
-            return;
-        case Stop::River:
-            getBusArrivalsByCode(currentStop->getID());
-            return;
-        }
-    }
-
-}
-
 //calls the correct function chain for each kind of Stop to download and process journey progress
 void ArrivalsLogic::fetchJourneyProgress() {
     if (currentVehicleId == "") return;
@@ -194,173 +258,120 @@ void ArrivalsLogic::fetchJourneyProgress() {
     getBusProgress(currentVehicleId);
 }
 
-//gets called when bus arrivals are downloaded and ready to be processed
-void ArrivalsLogic::onArrivalsDataReceived() {
-    downloadingArrivals = false;
-    emit downloadStateChanged();
-    QList<QJsonDocument> document = makeDocument(reply_arrivals);
-    QList<QJsonDocument>::iterator first = document.begin();
-
-    //server time UTC in msec from Epoch at the time of request
-    //use this to compare with expected arrival time, if device clock is not correctly set
-    //the arrival times are still accurately presented to user
-    if (first->array().begin() +2 >= first->array().end() ) { return; } //currentTime would be invalid
-    double currentTime = (*(first->array().begin() +2)).toDouble();
-    ArrivalsContainer tempContainer(arrivalsModel);
-    for (QList<QJsonDocument>::iterator iter = first + 1; iter < document.end(); ++iter) {
-        Vehicle bus;
-        if (iter->array().begin() + 5 >= iter->array().end() ) {
-            qDebug() << "";
-            //TODO throw exception
-            break;
-        }
-        bus.line = (*(iter->array().begin() + 1)).toString();
-        currentBusDirectionId =  QString::number((*(iter->array().begin() + 2)).toDouble());
-        bus.destination = (*(iter->array().begin() + 3)).toString();
-        bus.id = (*(iter->array().begin() + 4)).toString();//registration number
-        double delta = (*(iter->array().begin() + 5)).toDouble() - currentTime;
-        double inSec = delta / 1000;
-        double inMins = inSec / 60;
-        //round to whole numbers
-        bus.eta = std::round(inMins);
-        tempContainer.add(bus);
-    }
-    if (arrivalsContainer) {
-        arrivalsContainer->replace(tempContainer);
-    }
+//gets called whenever a part of bus progress data is decoded, stops are displayed before the download finishes
+void ArrivalsLogic::onBusProgressDecoded() {
+    applyProgress(pendingProgress, journeyProgressReader);
 }
 
-//gets called when bus progress data is downloaded and redy to be processed
+//gets called when bus progress data is downloaded
 void ArrivalsLogic::onBusProgressReceived() {
     downloadingJourneyProgress = false;
     emit downloadStateChanged();
-    QList<QJsonDocument> document = makeDocument(reply_journeyProgress);
-    if (document.begin() == document.end() ||
-            document.begin()->array().begin() + 2 >= document.begin()->array().end()) {
-        return;
-    }//nothing to do
-    double serverTime = (*(document.begin()->array().begin() +2)).toDouble();
-    //BUG check why list might be empty, server or client error
-    QList<QPair<QString, double>> list;
-    if (document.begin() + 1 >= document.end()) {
-    }
-    for (QList<QJsonDocument>::iterator iter = document.begin() + 1; iter < document.end(); ++iter) {
-        if (iter->array().begin() +2 >= iter->array().end()) {
-            //TODO throw
-            break;
-        }
-        QPair<QString, double> pair;
-        pair.first = (*(iter->array().begin() +1)).toString();
-        pair.second = (*(iter->array().begin() +2)).toDouble();
-        list.append(pair);
-    }
-    if (journeyProgressContainer) {
-        journeyProgressContainer->setTime(serverTime);
-        journeyProgressContainer->refreshData(list);
-    }
+    //updating might have been stopped whilst downloading
+    if (updatingJourneyProgress) { scheduleJourneyProgress(); }
 }
 
-//gets called when bus stop data is downloaded and ready to be processed
+//gets called when the details of a stop asked for by getBusStopByCode(const QString&) are downloaded
 void ArrivalsLogic::onBusStopDataReceived() {
-    downloadingStop = false;
-    emit downloadStateChanged();
-    QList<QJsonDocument> document = makeDocument(reply_busStop);
-    //only want the second array as the first one is the version array and there are only 2 arrays
-
-    if (document.begin() + 1 >= document.end()) { return; } //there is nothing to do
-    QList<QJsonDocument>::iterator dataArray = document.begin() + 1;
-    if (currentStop) {
-        if (dataArray->isArray() ) {
-            if (dataArray->array().begin() + 6 >= dataArray->array().end()) { return; } //TODO throw
-            //id is set in ArrivalsLogic::getBusStopByCode(const QString&)
-            currentStop->setName( (*(dataArray->array().begin() + 1)).toString() );
-            currentStop->setTowards( (*(dataArray->array().begin() + 3)).toString() );
-            currentStop->setStopPointIndicator( (*(dataArray->array().begin() + 4)).toString() );
-            currentStop->setLatitude( (*(dataArray->array().begin() + 5)).toDouble() );
-            currentStop->setLongitude( (*(dataArray->array().begin() + 6)).toDouble() );
-            if ( (*(dataArray->array().begin() + 2)).toString() == QString("SLRS") ) {
-                currentStop->setType(Stop::River);
-            }
-            else { currentStop->setType(Stop::Bus); }
-
-            currentStop->updated();
-            emit stopDataChanged();
+    finishStopPage();
+}
+
+//gets called when the stop array of readingStop is decoded, every page of the stop is given the details
+void ArrivalsLogic::onBusStopDecoded(const UraStop& stop) {
+    stopDetailsReceived = true;
+    for (QList<Stop*>::const_iterator iter = openStops.begin(); iter != openStops.end(); ++iter) {
+        if ((*iter)->getID() != readingStop) continue;
+        //id is set by ArrivalsLogic::openStop(const QString&)
+        (*iter)->setName(stop.name);
+        (*iter)->setTowards(stop.towards);
+        (*iter)->setStopPointIndicator(stop.indicator);
+        (*iter)->setLatitude(stop.latitude);
+        (*iter)->setLongitude(stop.longitude);
+        if (stop.type == QString("SLRS")) {
+            (*iter)->setType(Stop::River);
         }
-        else qDebug() << "Invalid QJsonArray";
+        else { (*iter)->setType(Stop::Bus); }
+        (*iter)->updated();
     }
 }
 
-//when getBusStopMessage(const QString&) download finishes
-void ArrivalsLogic::onBusStopMessageReceived() {
-    QList<QJsonDocument> document = makeDocument(reply_busStopMessage);
-    if (document.empty()) { return; } //nothing to do
-
-    QJsonArray versionArray = document.begin()->array();
-    if (versionArray.begin() + 2 < versionArray.end() ) {
-        double serverTime = (*(versionArray.begin() + 2 )).toDouble();
-        QMultiMap<int,QString> messages;
-        for (QList<QJsonDocument>::const_iterator iter = document.begin() + 1; iter < document.end(); ++iter) {
-            if (iter->array().begin() + 4 < iter->array().end()) {
-                int priority = (*(iter->array().begin() + 1)).toDouble();
-                QString text = (*(iter->array().begin() + 2)).toString();
-                double startTime = (*(iter->array().begin() + 3)).toDouble();
-                double expireTime = (*(iter->array().begin() + 4)).toDouble();
-                if (startTime <= serverTime && expireTime >= serverTime) {
-                    messages.insert(priority, text);
-                }
-            }
-            else {
-                qDebug() << "The array doesn't contain 4 elements.";
-                break;
-            }
-        }
-        fillCurrentStopMessages(messages);
+//journey progress etas are worked out again every tick so that they count down between downloads,
+//the progress bars of stop pages and journey progress move with it
+void ArrivalsLogic::onDisplayTimerTicked() {
+    if (journeyProgressContainer) { journeyProgressContainer->refreshEtas(); }
+    emit displayTimerTicked();
+}
+
+//a stop was made a favorite or stopped being one in db, the list of stops and the subscriptions of favorites follow it
+void ArrivalsLogic::onFavoriteChanged(const QString& code, bool favorite) {
+    stopsQueryModel->setFavorite(code, favorite);
+    if (!updatingFavorites) return;
+    if (favorite && !favoriteSubscriptions.contains(code)) {
+        favoriteSubscriptions.append(code);
+        stopArrivals->subscribe(code);
     }
-    else return;
+    else if (!favorite && favoriteSubscriptions.removeOne(code)) { stopArrivals->unsubscribe(code); }
 }
 
-void ArrivalsLogic::onDisplayTimerTicked() {
-    emit displayTimerTicked();
+void ArrivalsLogic::onImportProgressChanged(int percent) {
+    importProgress = percent;
+    emit importProgressChanged();
+}
+
+//gets called for every stop of journey progress as soon as it is decoded
+void ArrivalsLogic::onJourneyPointDecoded(const UraPrediction& prediction) {
+    pendingProgress.append(qMakePair(prediction.stopName, prediction.estimatedTime));
+}
+
+//stops pushed by the stream are only updated or added, stops already passed are kept as with polling
+void ArrivalsLogic::onJourneyProgressStreamDecoded() {
+    applyProgress(streamedProgress, journeyProgressStream->getReader());
+}
+
+//stops polling when the stream delivers data and polls again straight away when it breaks
+void ArrivalsLogic::onJourneyProgressStreamStateChanged() {
+    if (!updatingJourneyProgress) return;
+    if (!journeyProgressStream->isLive()) { fetchJourneyProgress(); }
+    scheduleJourneyProgress();
+}
+
+//gets called for every stop of getBusStopsByName(name) as soon as it is decoded
+void ArrivalsLogic::onListedStopDecoded(const UraStop& listedStop) {
+    StopRecord stop;
+    stop.name = listedStop.name;
+    stop.code = listedStop.code;
+    stop.towards = listedStop.towards;
+    stop.stopPointIndicator = listedStop.indicator;
+    stop.latitude = listedStop.latitude;
+    stop.longitude = listedStop.longitude;
+    const QString& stopPointType = listedStop.type;
+    if ( stopPointType == QString("SLRS")) {
+        stop.type = Stop::River;
+    }
+    else {
+        stop.type = Stop::Bus;
+    }
+    //The meaning of these codes are documented in the Bus arrivals API documentation
+    //only display sstops with these codes
+    if (stopPointType == "STBR" || stopPointType == "STBC" || stopPointType == "SRVA" ||
+        stopPointType == "STZZ" || stopPointType == "STBN" || stopPointType == "SLRS" ||
+        stopPointType == "STBS" || stopPointType == "STSS") {
+
+        //to prevent a bug when server returns a stop where code isNull() ie: Hammersmith Bus Station
+        if (!listedStop.code.isEmpty()) {
+            pendingStops << stop;
+            listedStops << listedStop.code;
+        }
+    }
 }
 
 //gets called when the list of bus stops are downloaded by getBusStopsByName(name)
+//they are written as one batch and shown by onStopsAdded() once it is committed
 void ArrivalsLogic::onListOfBusStopsReceived() {
     downloadingListOfStops = false;
     emit downloadStateChanged();
-    QList<QJsonDocument> document = makeDocument(reply_stops);
-    QString stopPointType;
-    //skip version array
-    for (QList<QJsonDocument>::const_iterator iter = document.begin() + 1;iter < document.end();++iter) {
-        if (iter->array().begin() + 7 >= iter->array().end()) {
-            break;
-        } //TODO throw
-        Stop stop(databaseManager);
-        stop.setName((*(iter->array().begin() + 1)).toString());
-        stop.setID((*(iter->array().begin() + 2)).toString());
-        stop.setTowards((*(iter->array().begin() + 4)).toString());
-        stop.setStopPointIndicator((*(iter->array().begin() + 5)).toString());
-        stop.setLatitude((*(iter->array().begin() + 6)).toDouble());
-        stop.setLongitude((*(iter->array().begin() + 7)).toDouble());
-        stopPointType = (*(iter->array().begin() + 3)).toString();
-        if ( stopPointType == QString("SLRS")) {
-            stop.setType(Stop::River);
-        }
-        else {
-            stop.setType(Stop::Bus);
-        }
-        //The meaning of these codes are documented in the Bus arrivals API documentation
-        //only display sstops with these codes
-        if (stopPointType == "STBR" || stopPointType == "STBC" || stopPointType == "SRVA" ||
-            stopPointType == "STZZ" || stopPointType == "STBN" || stopPointType == "SLRS" ||
-            stopPointType == "STBS" || stopPointType == "STSS") {
-
-            //to prevent a bug when server returns a stop where code isNull() ie: Hammersmith Bus Station
-            if (!(*(iter->array().begin() + 2)).isNull()) { stop.addToDb(); }
-        }
-    }
-    if (stopsQueryModel) {
-        stopsQueryModel->showStops(Stop::Bus);
-    }
+    if (databaseManager && !pendingStops.isEmpty()) { databaseManager->addStops(pendingStops); }
+    pendingStops.clear();
 }
 
 //signals to gui that there is a new next stop
@@ -382,7 +393,7 @@ void ArrivalsLogic::onStationsDownloaded() {
         reply_stations->deleteLater();
         QUrl url = reply_stations->url().resolved(redirectUrl.toUrl());
         qDebug() << "redirecting to" << url;
-        reply_stations = networkMngr->get(QNetworkRequest(url));
+        reply_stations = requestManager->get(url, RequestManager::Background, "stations");
 
         connect(reply_stations,SIGNAL(finished()),this, SLOT(onStationsDownloaded()) );
     }
@@ -409,92 +420,139 @@ void ArrivalsLogic::onStationsDownloaded() {
     }
 }
 
-//public slots:
-//called by BusStopPage onDestruction()
-void ArrivalsLogic::clearCurrentStop() {
-    currentStop->clear();
-    currentStopMessages.clear();
-}
-
-//makes stop a favorite or removes it from favorites depending on the second arg
-bool ArrivalsLogic::favorStop(const QString& code, bool b) {
-    if (!databaseManager) { return false; }
-    bool ok = false;
-    if (b) {
-        ok = databaseManager->makeFavorite(code);
-        stopsQueryModel->showStops(Stop::Bus);
-        return ok;
+//the query of fetchStopPage() is finished, stop details have already been handed out as they arrived
+void ArrivalsLogic::onStopPageDataReceived() {
+    if (!pendingMessages.isEmpty()) {
+        QString messages = formatMessages(pendingMessages);
+        for (QList<Stop*>::const_iterator iter = openStops.begin(); iter != openStops.end(); ++iter) {
+            if ((*iter)->getID() != readingStop) continue;
+            (*iter)->setMessages(messages);
+            (*iter)->updated();
+        }
     }
-    else {
-        ok = databaseManager->unFavorite(code);
-        stopsQueryModel->showStops(Stop::Bus);
-        return ok;
+    pendingMessages.clear();
+    //a stop whose details didn't come with the query needs asking on its own
+    if (!stopDetailsReceived) {
+        getBusStopByCode(readingStop);
+        return;
     }
+    finishStopPage();
 }
 
-ArrivalsProxyModel* ArrivalsLogic::getArrivalsModel() { return arrivalsProxyModel; }
+void ArrivalsLogic::onStopPageMessageDecoded(const UraMessage& message) {
+    addMessage(message, stopPageReader);
+}
 
-//downloads bus stop data for a bus stop  with a given code
-void ArrivalsLogic::getBusStopByCode(const QString& code) {
-    currentStop->setID(code);
+//gets called when the executor has written stops to db, the ones found by getBusStopsByName() are shown
+void ArrivalsLogic::onStopsAdded(const QStringList& codes) {
+    QStringList shown;
+    for (QStringList::const_iterator iter = codes.begin(); iter != codes.end(); ++iter) {
+        if (listedStops.removeOne(*iter)) { shown << *iter; }
+    }
+    if (stopsQueryModel && !shown.isEmpty()) { stopsQueryModel->addCodes(shown); }
+}
 
-    QString stopcode = QString("StopCode1=") + code;
-    QString returnList = "&ReturnList=StopPointName,Towards,StopPointIndicator,StopPointType,Latitude,Longitude";
-    QString request = baseUrl + stopcode + returnList;
-    QUrl url(request);
-    downloadingStop = true;
-    emit downloadStateChanged();
-    reply_busStop = networkMngr->get(QNetworkRequest(url));
+//the import of stops.csv is only remembered once it is in db
+void ArrivalsLogic::onStopsImported(bool ok) {
+    if (ok && pendingImport.isValid()) { QSettings().setValue("stops/imported", pendingImport); }
+    else if (!ok) { qDebug() << "Import Failed"; }
+    pendingImport = QDateTime();
+}
 
-    connect(reply_busStop, SIGNAL(finished()), this, SLOT(onBusStopDataReceived()) );
+//gets called for every stop of journey progress pushed by the stream
+void ArrivalsLogic::onStreamedJourneyPointDecoded(const UraPrediction& prediction) {
+    streamedProgress.append(qMakePair(prediction.stopName, prediction.estimatedTime));
 }
 
-void ArrivalsLogic::getBusStopMessage(const QString& code) {
-    QString stopCode = QString("StopCode1=") + code;
-    QString returnList = "&ReturnList=MessagePriority,MessageText,StartTime,ExpireTime";
-    QString request = baseUrl + stopCode + returnList;
-    QUrl url(request);
+//reschedules downloads when user switches between the app, its cover or other apps
+void ArrivalsLogic::onVisibilityChanged() {
+    if (!coverLogic) return;
+    if (updatingJourneyProgress) {
+        int before = journeyProgressScheduler.getVisibility();
+        scheduleJourneyProgress();
+        if (journeyProgressScheduler.getVisibility() > before) { fetchJourneyProgress(); }
+    }
+    //subscribed stops are displayed by stop pages, by DeparturePage and by the cover of either
+    stopArrivals->setVisibility(qMax(coverLogic->getVisibility(CoverLogic::None), coverLogic->getVisibility(CoverLogic::BusStopPage)));
+
+    //no need to tick when nothing is displayed
+    bool displayed = (!openStops.isEmpty() && stopArrivals->getVisibility() != PollScheduler::Hidden) ||
+                     (updatingJourneyProgress && journeyProgressScheduler.getVisibility() != PollScheduler::Hidden);
+    if (displayed && !displayTimer->isActive()) {
+        onDisplayTimerTicked();
+        displayTimer->start(1000);
+    }
+    else if (!displayed) { displayTimer->stop(); }
+}
 
-    reply_busStopMessage = networkMngr->get(QNetworkRequest(url));
+//public slots:
+//called by BusStopPage onDestruction() with the stop returned by openStop(),
+//the details of the stop are no longer asked for if no other page shows it
+void ArrivalsLogic::closeStop(Stop* stop) {
+    if (!openStops.removeOne(stop)) return;
+    QString code = stop->getID();
+    stop->deleteLater();
+    onVisibilityChanged();
+    for (QList<Stop*>::const_iterator iter = openStops.begin(); iter != openStops.end(); ++iter) {
+        if ((*iter)->getID() == code) return;
+    }
+    queuedStops.removeOne(code);
+    if (readingStop == code) {
+        stopPageReader->abort();
+        busStopReader->abort();
+        finishStopPage();
+    }
+}
 
-    connect(reply_busStopMessage, SIGNAL(finished()), this, SLOT(onBusStopMessageReceived()) );
+//makes stop a favorite or removes it from favorites depending on the second arg, it is written in the background
+//favoritesChanged() is emitted once it is done, returns false if it can't be written
+bool ArrivalsLogic::favorStop(const QString& code, bool b) {
+    if (!databaseManager) { return false; }
+    if (b) { return databaseManager->makeFavorite(code); }
+    return databaseManager->unFavorite(code);
 }
 
-//downloads a list of stops that bear the same name
+//returns which of the codes are favorites so that a view can ask about every stop it shows at once
+QStringList ArrivalsLogic::favoritesAmong(const QStringList& codes) const {
+    return databaseManager ? databaseManager->favoritesAmong(codes) : QStringList();
+}
+
+//shows the stops in db matching name, they are only downloaded if there is none
 void ArrivalsLogic::getBusStopsByName(const QString& name) {
+    if (stopsQueryModel->search(name)) { return; }
+    listedStops.clear();
+    pendingStops.clear();
     QString stopPointName = QString("StopPointName=") + name;
-    QString returnList = "&ReturnList=StopPointName,StopCode1,Towards,StopPointIndicator,StopPointType,Latitude,Longitude";
-    QString request = baseUrl + stopPointName + returnList;
+    QString request = baseUrl + stopPointName + stopsReader->getReturnList();
     QUrl url = request;
     downloadingListOfStops = true;
     emit downloadStateChanged();
-    reply_stops = networkMngr->get(QNetworkRequest(url) );
-    connect(reply_stops, SIGNAL(finished()), this, SLOT(onListOfBusStopsReceived()) );
+    stopsReader->read(requestManager->get(url, RequestManager::Foreground, "stopsByName"));
 }
 
 QString ArrivalsLogic::getCurrentDestination() const { return currentDestination;}
 
-Stop* ArrivalsLogic::getCurrentStop() { return currentStop; }
+QString ArrivalsLogic::getCurrentVehicleLine() const { return currentVehicleLine; }
 
-QString ArrivalsLogic::getCurrentStopMessages() const {
-    return currentStopMessages;
-}
+//returns a model of arrivals for a subscribed stop, nullptr if nobody is subscribed to the stop
+ArrivalsProxyModel* ArrivalsLogic::getFavoriteArrivalsModel(const QString& code) { return stopArrivals->getModel(code); }
 
-QString ArrivalsLogic::getCurrentVehicleLine() const { return currentVehicleLine; }
+//returns eta in minutes of the first vehicle arriving to a subscribed stop or -1 if there is none
+int ArrivalsLogic::getFavoriteNextEta(const QString& code) const { return stopArrivals->getNextEta(code); }
 
-double ArrivalsLogic::getTimerProgress_arrivals() const {
-    double interval = arrivalsTimer->interval();
-    double remaining = arrivalsTimer->remainingTime();
-    return (interval - remaining) / interval * 100;
-}
+//returns the line of the first vehicle arriving to a subscribed stop
+QString ArrivalsLogic::getFavoriteNextLine(const QString& code) const { return stopArrivals->getNextLine(code); }
+
+double ArrivalsLogic::getTimerProgress_arrivals() const { return stopArrivals->getTimerProgress(); }
 
 double ArrivalsLogic::getTimerProgress_journeyProgress() const {
+    if (journeyProgressStream->isLive()) { return 0; }
     double interval = journeyProgressTimer->interval();
     double remaining = journeyProgressTimer->remainingTime();
     return (interval - remaining) / interval * 100;
 }
 
-bool ArrivalsLogic::isDownloadingArrivals() const { return downloadingArrivals; }
+bool ArrivalsLogic::isDownloadingArrivals() const { return stopArrivals->isDownloading(); }
 
 bool ArrivalsLogic::isDownloadingJourneyProgress() const { return downloadingJourneyProgress; }
 
@@ -502,6 +560,9 @@ bool ArrivalsLogic::isDownloadingListOfStops() const { return downloadingListOfS
 
 bool ArrivalsLogic::isDownloadingStop() const { return downloadingStop; }
 
+//returns how much of stops.csv has been imported in percent
+int ArrivalsLogic::getImportProgress() const { return importProgress; }
+
 ArrivalsProxyModel* ArrivalsLogic::getJourneyProgressModel() { return journeyProgressContainer->getModel(); }
 
 QString ArrivalsLogic::getNextStop() { return journeyProgressContainer->getNextStop(); }
@@ -510,13 +571,52 @@ StopsQueryModel* ArrivalsLogic::getStopsQueryModel() { return stopsQueryModel; }
 
 bool ArrivalsLogic::isStopFavorite(const QString& code) { return databaseManager->isFavorite(code); }
 
-void ArrivalsLogic::refreshArrivalsModel() {
-    arrivalsModel->refresh();
+//returns true if predictions are streamed while they are visible
+bool ArrivalsLogic::isStreamingEnabled() const { return streaming; }
+
+//called when a stop page opens, returns a stop of its own to every page, see closeStop()
+//details of the stop and its messages are asked with a single query, arrivals come from subscribeStop() meanwhile
+//so that the page has all of its content after one round trip
+Stop* ArrivalsLogic::openStop(const QString& code) {
+    Stop* stop = new Stop(databaseManager);
+    stop->setID(code);
+    if (databaseManager) { databaseManager->touchStop(code); }
+    bool asked = readingStop == code || queuedStops.contains(code);
+    //another page of the same stop already has the details
+    for (QList<Stop*>::const_iterator iter = openStops.begin(); iter != openStops.end(); ++iter) {
+        if ((*iter)->getID() != code || (*iter)->getType() == Stop::None) continue;
+        stop->setName((*iter)->getName());
+        stop->setTowards((*iter)->getTowards());
+        stop->setStopPointIndicator((*iter)->getStopPointIndicator());
+        stop->setLatitude((*iter)->getLatitude());
+        stop->setLongitude((*iter)->getLongitude());
+        stop->setMessages((*iter)->getMessages());
+        stop->setType((*iter)->getType());
+        asked = true;
+        break;
+    }
+    openStops.append(stop);
+    if (!asked) {
+        queuedStops.append(code);
+        fetchStopPage();
+    }
+    onVisibilityChanged();
+    return stop;
 }
 
+//downloads arrivals of every subscribed stop right away
+void ArrivalsLogic::refreshArrivals() { stopArrivals->fetch(); }
+
+//makes the views of a subscribed stop lay out every row again
+void ArrivalsLogic::refreshArrivalsModel(const QString& code) { stopArrivals->refresh(code); }
+
 void ArrivalsLogic::setCurrentDestination(const QString& destination) { currentDestination = destination; }
 
-void ArrivalsLogic::setCurrentVehicleId(const QString& id) { currentVehicleId = id;}
+//the direction of the vehicle is needed to ask for its journey progress
+void ArrivalsLogic::setCurrentVehicleId(const QString& id) {
+    currentVehicleId = id;
+    currentBusDirectionId = stopArrivals->getDirection(id);
+}
 
 void ArrivalsLogic::setCurrentVehicleLine(const QString& line) { currentVehicleLine = line; }
 
@@ -528,38 +628,63 @@ void ArrivalsLogic::setStopsQueryModel(int type) {
         downloadStations();
     }
     else qDebug() << "There are already tubestations in db";
+    importStops();
     stopsQueryModel->showStops(type);
 }
 
-//starts timer to periodically download arrivals data
-//time interval might be different for each kind of stops
-void ArrivalsLogic::startArrivalsUpdate() {
-    fetchArrivalsData();
-    arrivalsTimer->start(30000);//30 sec
-    displayTimer->start(16);
+//switches between streaming and polling, the choice is remembered
+void ArrivalsLogic::setStreamingEnabled(bool enabled) {
+    if (streaming == enabled) return;
+    streaming = enabled;
+    QSettings().setValue("ura/streaming", streaming);
+    stopArrivals->setStreamingEnabled(streaming);
+    if (updatingJourneyProgress) { scheduleJourneyProgress(); }
+}
+
+//subscribes to every favorite stop, they are downloaded together with other subscribed stops
+void ArrivalsLogic::startFavoriteArrivalsUpdate() {
+    if (!databaseManager || updatingFavorites) return;
+    updatingFavorites = true;
+    favoriteSubscriptions = databaseManager->getFavorites();
+    for (QStringList::const_iterator iter = favoriteSubscriptions.begin(); iter != favoriteSubscriptions.end(); ++iter) {
+        stopArrivals->subscribe(*iter);
+    }
 }
 
 //starts timer to periodically download journey progress data
 //time interval might be different for each kind of stops
 void ArrivalsLogic::startJourneyProgressUpdate() {
     qDebug() << "***startJourneyProgressUpdate() ***";
+    updatingJourneyProgress = true;
     fetchJourneyProgress();
-    journeyProgressTimer->start(30000);//30 sec
-    displayTimer->start(16);
+    scheduleJourneyProgress();
+    displayTimer->start(1000);
 }
 
-//stops timer to download arrivals data
-void ArrivalsLogic::stopArrivalsUpdate() {
-    qDebug() << "updating stopped.";
-    displayTimer->stop();
-    arrivalsTimer->stop();
-    clearArrivalsData();
+//drops the subscriptions of favorite stops, stops other views are subscribed to keep updating
+void ArrivalsLogic::stopFavoriteArrivalsUpdate() {
+    if (!updatingFavorites) return;
+    updatingFavorites = false;
+    for (QStringList::const_iterator iter = favoriteSubscriptions.begin(); iter != favoriteSubscriptions.end(); ++iter) {
+        stopArrivals->unsubscribe(*iter);
+    }
+    favoriteSubscriptions.clear();
 }
 
 //stops timer to download journey progress data
 void ArrivalsLogic::stopJourneyProgressUpdate() {
-    displayTimer->stop();
+    updatingJourneyProgress = false;
+    onVisibilityChanged();
     journeyProgressTimer->stop();
+    journeyProgressStream->stop();
+    streamedProgress.clear();
+    journeyProgressScheduler.reset();
     clearJourneyProgressData();
 }
 
+//registers a view of a stop and returns the model of its arrivals shared by every view of the stop,
+//the stop is downloaded together with the other subscribed stops until unsubscribeStop() is called as many times
+ArrivalsProxyModel* ArrivalsLogic::subscribeStop(const QString& code) { return stopArrivals->subscribe(code); }
+
+void ArrivalsLogic::unsubscribeStop(const QString& code) { stopArrivals->unsubscribe(code); }
+
@@ -25,37 +25,45 @@ THE SOFTWARE.
 #ifndef ARRIVALSLOGIC_H
 #define ARRIVALSLOGIC_H
 
+#include <QDateTime>
 #include <QHash>
 #include <QList>
+#include <QMultiMap>
 #include <QObject>
+#include <QPair>
 #include <QString>
 #include <QStringList>
+#include "arrivals/pollscheduler.h"
+#include "arrivals/urarecords.h"
+#include "database/stoprecord.h"
 
-class ArrivalsContainer;
-class ArrivalsModel;
 class ArrivalsProxyModel;
+class CoverLogic;
 class DatabaseManager;
 class JourneyProgressContainer;
-class QNetworkAccessManager;
-class QNetworkReply;
+class ManagedReply;
+class MultiStopArrivals;
 class QTimer;
+class RequestManager;
 class Stop;
 class StopsQueryModel;
 class QStringListModel;
+class UraReader;
+class UraStream;
 
 //This class is reponsible to providing the logic to all departure related queries from gui
+// !!! Parent MUST be a RequestManager or a nullptr !!!
 class ArrivalsLogic : public QObject
 {
     Q_OBJECT
 public:
     explicit ArrivalsLogic(DatabaseManager* = 0, QObject* parent = 0);
+    void setCoverLogic(CoverLogic*);
 private:
     QString activeStops;
-    ArrivalsContainer* arrivalsContainer;
-    ArrivalsModel* arrivalsModel;
-    ArrivalsProxyModel* arrivalsProxyModel;
-    QTimer* arrivalsTimer;
     QString baseUrl;
+    UraReader* busStopReader;
+    CoverLogic* coverLogic;
     QString currentBusDirectionId;
     QString currentDestination;
 
@@ -63,78 +71,113 @@ private:
     QString currentVehicleId;
     QString currentVehicleLine;
     DatabaseManager* databaseManager;
-    Stop* currentStop;
-    QString currentStopMessages;
     QTimer* displayTimer;
-    bool downloadingArrivals;
     bool downloadingJourneyProgress;
     bool downloadingListOfStops;
     bool downloadingStop;
-    QNetworkAccessManager* networkMngr;
+    QStringList favoriteSubscriptions;//favorite stops subscribed to on behalf of DeparturePage
+    int importProgress;//of stops.csv in percent
     JourneyProgressContainer* journeyProgressContainer;
+    UraReader* journeyProgressReader;
+    PollScheduler journeyProgressScheduler;
+    UraStream* journeyProgressStream;
     QTimer* journeyProgressTimer;
-    QNetworkReply* reply_arrivals;
-    QNetworkReply* reply_busStop;
-    QNetworkReply* reply_busStopMessage;
-    QNetworkReply* reply_journeyProgress;
-    QNetworkReply* reply_stations;
-    QNetworkReply* reply_stops;
+    QStringList listedStops;//codes of stops found by getBusStopsByName() that are not shown yet
+    QList<Stop*> openStops;//one for every stop page, see openStop()
+    QMultiMap<int,QString> pendingMessages;//filled while messages are being decoded
+    QDateTime pendingImport;//last modification of stops.csv being imported
+    QList<QPair<QString,double> > pendingProgress;//journey points decoded but not yet in container
+    QList<StopRecord> pendingStops;//decoded by getBusStopsByName() but not yet in db
+    QStringList queuedStops;//opened stops waiting for their details and messages
+    QString readingStop;//code of the stop whose details and messages are being downloaded
+    ManagedReply* reply_stations;
+    RequestManager* requestManager;
+    MultiStopArrivals* stopArrivals;//stop pages, favorites and the cover subscribe to the stops they show
+    bool stopDetailsReceived;//the query of fetchStopPage() brought the details of the stop
+    UraReader* stopPageReader;//stop details and messages with a single query
     StopsQueryModel* stopsQueryModel;
+    UraReader* stopsReader;
+    QList<QPair<QString,double> > streamedProgress;//pushed by the stream but not yet in container
+    bool streaming;//stream predictions instead of polling while they are visible
+    bool updatingFavorites;
+    bool updatingJourneyProgress;
 signals:
-    void currentStopMessagesChanged();
     void downloadStateChanged();
+    void favoriteArrivalsChanged();
+    void favoritesChanged();
+    void importProgressChanged();
     void nextStopChanged();
     void displayTimerTicked();
-    void stopDataChanged();
 private:
-    void clearArrivalsData();
+    void addMessage(const UraMessage&, const UraReader*);
+    void applyProgress(QList<QPair<QString,double> >&, const UraReader*);
     void clearJourneyProgressData();
     void downloadStations();
-    void fillCurrentStopMessages(const QMap<int,QString>&);
-    void getBusArrivalsByCode(const QString& code);
+    void fetchStopPage();
+    void finishStopPage();
+    QString formatMessages(const QMap<int,QString>&) const;
+    void getBusStopByCode(const QString& code);
+    void importStops();
     void getBusProgress(const QString&);
-    QList<QJsonDocument> makeDocument(QNetworkReply*);
+    void scheduleJourneyProgress();
 private slots:
-    void fetchArrivalsData();
     void fetchJourneyProgress();
-    void onArrivalsDataReceived();
+    void onBusProgressDecoded();
     void onBusProgressReceived();
     void onBusStopDataReceived();
-    void onBusStopMessageReceived();
+    void onBusStopDecoded(const UraStop&);
     void onDisplayTimerTicked();
+    void onFavoriteChanged(const QString& code, bool favorite);
+    void onImportProgressChanged(int percent);
+    void onJourneyPointDecoded(const UraPrediction&);
+    void onJourneyProgressStreamDecoded();
+    void onJourneyProgressStreamStateChanged();
+    void onListedStopDecoded(const UraStop&);
     void onListOfBusStopsReceived();
     void onProgressDataChanged();
     void onStationsDownloaded();
+    void onStopPageDataReceived();
+    void onStopPageMessageDecoded(const UraMessage&);
+    void onStopsAdded(const QStringList& codes);
+    void onStopsImported(bool ok);
+    void onStreamedJourneyPointDecoded(const UraPrediction&);
+    void onVisibilityChanged();
 public slots:
-    void clearCurrentStop();
+    void closeStop(Stop*);
     bool favorStop(const QString& code, bool);
-    ArrivalsProxyModel* getArrivalsModel();
-    void getBusStopByCode(const QString& code);
-    void getBusStopMessage(const QString& code);
+    QStringList favoritesAmong(const QStringList& codes) const;
     void getBusStopsByName(const QString& name);
     QString getCurrentDestination() const;
-    Stop* getCurrentStop();
-    QString getCurrentStopMessages() const;
     QString getCurrentVehicleLine() const;
+    ArrivalsProxyModel* getFavoriteArrivalsModel(const QString& code);
+    int getFavoriteNextEta(const QString& code) const;
+    QString getFavoriteNextLine(const QString& code) const;
     double getTimerProgress_arrivals() const;
     double getTimerProgress_journeyProgress() const;
     bool isDownloadingArrivals() const;
     bool isDownloadingJourneyProgress() const;
     bool isDownloadingListOfStops() const;
     bool isDownloadingStop() const;
+    int getImportProgress() const;
     ArrivalsProxyModel* getJourneyProgressModel();
     QString getNextStop();
     StopsQueryModel* getStopsQueryModel();
     bool isStopFavorite(const QString& code);
-    void refreshArrivalsModel();
+    bool isStreamingEnabled() const;
+    Stop* openStop(const QString& code);
+    void refreshArrivals();
+    void refreshArrivalsModel(const QString& code);
     void setCurrentDestination(const QString& destination);
     void setCurrentVehicleId(const QString& id);
     void setCurrentVehicleLine(const QString& line);
     void setStopsQueryModel(int type);
-    void startArrivalsUpdate();
+    void setStreamingEnabled(bool);
+    void startFavoriteArrivalsUpdate();
     void startJourneyProgressUpdate();
-    void stopArrivalsUpdate();
+    void stopFavoriteArrivalsUpdate();
     void stopJourneyProgressUpdate();
+    ArrivalsProxyModel* subscribeStop(const QString& code);
+    void unsubscribeStop(const QString& code);
 };
 
 #endif // ARRIVALSLOGIC_H
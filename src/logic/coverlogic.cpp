@@ -25,17 +25,50 @@ THE SOFTWARE.
 
 #include "coverlogic.h"
 #include <QDebug>
+#include <QGuiApplication>
 
 CoverLogic::CoverLogic(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    applicationActive(true),
+    coverActive(false),
+    currentPage(None)
 {
+    if (qGuiApp) {
+        applicationActive = qGuiApp->applicationState() == Qt::ApplicationActive;
+        connect(qGuiApp, SIGNAL(applicationStateChanged(Qt::ApplicationState)),
+                this, SLOT(onApplicationStateChanged(Qt::ApplicationState)) );
+    }
+}
+
+//private slots:
+void CoverLogic::onApplicationStateChanged(Qt::ApplicationState state) {
+    bool active = state == Qt::ApplicationActive;
+    if (active == applicationActive) return;
+    applicationActive = active;
+    emit visibilityChanged();
 }
 
 //public slots:
 int CoverLogic::getCurrentPage() { return currentPage; }
 
+//returns how visible the data of a page is, it is only shown if the page is the current one,
+//data that doesn't belong to a page is on screen whenever the app is
+int CoverLogic::getVisibility(int page) const {
+    if (applicationActive) { return page == None || page == currentPage ? OnScreen : Hidden; }
+    if (coverActive && page == currentPage) { return OnCover; }
+    return Hidden;
+}
+
+//called by cover to report whether it is being displayed
+void CoverLogic::reportCoverStatus(bool active) {
+    if (active == coverActive) return;
+    coverActive = active;
+    emit visibilityChanged();
+}
+
 //called by gui to report what page is currently active
 void CoverLogic::reportPage(int page) {
     currentPage = page;
     emit pageChanged();
+    emit visibilityChanged();
 }
@@ -32,15 +32,25 @@ class CoverLogic : public QObject
 {
     Q_OBJECT
     Q_ENUMS(PageType)
+    Q_ENUMS(Visibility)
 public:
     enum PageType { None, BusStopPage, JourneyProgressPage };
+    //how visible the data of a page is to user
+    enum Visibility { Hidden, OnCover, OnScreen };
     explicit CoverLogic(QObject *parent = 0);
 private:
+    bool applicationActive;
+    bool coverActive;
     int currentPage;
 signals:
     void pageChanged();
+    void visibilityChanged();
+private slots:
+    void onApplicationStateChanged(Qt::ApplicationState);
 public slots:
     int getCurrentPage();
+    int getVisibility(int page) const;
+    void reportCoverStatus(bool active);
     void reportPage(int);
 
 };
@@ -23,14 +23,26 @@ THE SOFTWARE.
 */
 
 #include "database.h"
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QSettings>
 #include <QSqlQuery>
 #include <QStandardPaths>
+#include <QThread>
+#include "../arrivals/vehicle.h"
+#include "databaseexecutor.h"
 
+namespace {
+    //stops found by searches that are kept unless it is set otherwise in "stops/cacheLimit"
+    const int defaultCacheLimit = 2000;
+}//end of unnamed namespace
 
-Database::Database() : db(QSqlDatabase::addDatabase("QSQLITE"))
+
+Database::Database() : db(QSqlDatabase::addDatabase("QSQLITE")),
+                       executor(0),
+                       workerThread(0)
 {
     QString path = QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/data-2.0.sqlite";
 
@@ -38,14 +50,42 @@ Database::Database() : db(QSqlDatabase::addDatabase("QSQLITE"))
     if (!dir.exists()) {
         dir.mkpath(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
     }
-    if (upgrade()) {
-        db.setDatabaseName(path);
-        bool ok = open();
-        if (!ok) qDebug() << "Couldn't open db.";
+    //every write is run on a thread of its own, see DatabaseExecutor, the schema is up to date once open() returns
+    workerThread = new QThread();
+    executor = new DatabaseExecutor(path);
+    executor->setCacheLimit(QSettings().value("stops/cacheLimit", defaultCacheLimit).toInt());
+    executor->moveToThread(workerThread);
+    QObject::connect(workerThread, SIGNAL(finished()), executor, SLOT(deleteLater()) );
+    workerThread->start();
+    bool ok = false;
+    QMetaObject::invokeMethod(executor, "open", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, ok));
+    if (!ok) {
+        qDebug() << "Couldn't open db.";
+        workerThread->quit();
+        workerThread->wait();
+        delete workerThread;
+        workerThread = 0;
+        executor = 0;
+        return;
+    }
+    db.setDatabaseName(path);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+    if (!open()) qDebug() << "Couldn't open db." << db.lastError();
+    else {
+        loadFavorites();
+        readers.setPath(path);
     }
 }
 
 Database::~Database() {
+    if (workerThread) {
+        //writes still queued are not lost
+        QMetaObject::invokeMethod(executor, "runJobs", Qt::BlockingQueuedConnection);
+        workerThread->quit();
+        workerThread->wait();
+        delete workerThread;
+    }
+    statements.clear();
     close();
 }
 
@@ -55,296 +95,261 @@ void Database::close() { db.close(); }
 
 //returns how many items in db has a rank, returns -1 if unsuccessful
 int Database::countRanked() const {
-    QSqlQuery query;
-    query.setForwardOnly(true);
-    bool ok = query.exec("SELECT * FROM stopstable WHERE rank IS NOT NULL");
-    query.last();
-    int count;
-    if (query.at() < 0) { count = 0; }
-    else { count = query.at() + 1; }
-    if (ok) return count;
-    else {
-        qDebug() << lastError();
+    QSqlQuery query = readers.prepare("SELECT COUNT(*) FROM stopstable WHERE rank IS NOT NULL");
+    if (!query.exec() || !query.next()) {
+        qDebug() << query.lastError();
         return -1;
     }
+    int count = query.value(0).toInt();
+    query.finish();
+    return count;
 }
 
-//creates stopstable and returns true if successful otherwise returns false
-bool Database::createStopsTable() {
-    if (!isOpen()) { open();}
-    if (isStopsTable()) { return true; }
-    if (isOpen()) {
-        QSqlQuery query;
-        bool ret = query.exec("CREATE TABLE stopstable "
-                              "(name STRING, "
-                              "code STRING UNIQUE, "
-                              "type INTEGER, "
-                              "towards STRING, "
-                              "latitude STRING, "
-                              "longitude STRING, "
-                              "stoppointindicator STRING, "
-                              "favorite INTEGER, "
-                              "rank INTEGER)");
-        if (!ret) {
-            qDebug() << "query failed.";
-            qDebug() << lastError();
-        }
-        return ret;
-    }
-    else {
-        qDebug() << "database is closed";
-        return false;
-    }
+//returns the rank of a given item by code or 0 if it is not a favorite, ranks of favorites are always positive
+qint64 Database::getRank(const QString& code) const { return favorites.value(code, 0); }
+
+//adds a stop to the in-memory indexes so that it is found before the executor writes it
+void Database::indexStop(const StopRecord& stop) {
+    StopIndex::Entry entry;
+    entry.code = stop.code;
+    entry.name = stop.name;
+    entry.type = stop.type;
+    entry.latitude = stop.latitude;
+    entry.longitude = stop.longitude;
+    stopIndex.insert(entry);
+    stopNameIndex.insert(stop.code, stop.type, stop.name, stop.towards, stop.stopPointIndicator);
 }
 
-//returns the rank of a given item by code or returns negative upon failure
-int Database::getRank(const QString& code) const {
-    QSqlQuery query;
-    query.prepare("SELECT rank FROM stopstable WHERE code = :code");
-    query.bindValue(":code", code);
-    query.exec();
-    query.first();
-    return query.value(0).toInt();
-}
-
-
-bool Database::isOpen() const { return db.isOpen(); }
-
-//returns true if stopstable is already present otherwise returns false
-bool Database::isStopsTable() const {
-    if (!isOpen()) { return false; }
-    QSqlQuery query;
-    bool ret = query.exec("SELECT * FROM stopstable");
-    return ret;
-}
-
-bool Database::open() { return db.open(); }
-
-bool Database::upgrade() {
-    QString path_1 = QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/data-1.0.sqlite";
-    QFile file_1(path_1);
-
-    if (file_1.exists()) {
-        db.setDatabaseName(path_1);
-        bool ok = open();
-        if (!ok) {
-            qDebug() << "Couldn't open db 1.0.";
-            return ok;
-        }
-        QSqlQuery query;
-        ok = query.exec("ALTER TABLE stopstable ADD COLUMN rank INTEGER");
-        if (!ok) {
-            qDebug() << "Upgrade from 1.0 failed." << lastError();
-        }
-        close();
-        QString newName = QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/data-2.0.sqlite";
-        bool rename_ok = file_1.rename(newName);
-        if (!rename_ok) qDebug() << "Rename failed";
-        return ok && rename_ok;
+//fills favorites from stopstable at startup, the executor keeps it up to date after that
+//returns false if stopstable couldn't be read
+bool Database::loadFavorites() {
+    favorites.clear();
+    QSqlQuery query = statements.prepare("SELECT code, rank FROM stopstable WHERE favorite = 1");
+    if (!query.exec()) {
+        qDebug() << "loadFavorites() failed" << query.lastError();
+        return false;
+    }
+    while (query.next()) {
+        favorites.insert(query.value(0).toString(), query.value(1).toLongLong());
     }
     return true;
 }
 
+bool Database::open() { return db.open(); }
+
 //public:
-//adds a new stop to stopstable and returns true if successful otherwise returns false
+//queues a new stop for the executor, returns false if it can't be written
+//DatabaseExecutor::stopsAdded() tells when it is written, a favorite is written before a makeFavorite() queued after it
 bool Database::addStop(const QString& name,const QString& code,int type, QString& towards, double latitude, double longitude,
              const QString& stopPointIndicator, bool favorite) {
-    if (createStopsTable()) {
-        QSqlQuery query;
-        query.prepare(
-                      "INSERT OR IGNORE INTO stopstable (name, code, type, towards, latitude, longitude, stoppointindicator, favorite) "
-                      "VALUES (:name, :code, :type, :towards, :latitude, :longitude, :stoppointindicator, :favorite)"
-                      );
-        query.bindValue(":name", name);
-        query.bindValue(":code", code);
-        query.bindValue(":type", type);
-        query.bindValue(":towards", towards);
-        query.bindValue(":latitude", latitude);
-        query.bindValue(":longitude", longitude);
-        query.bindValue(":stoppointindicator", stopPointIndicator);
-        query.bindValue(":favorite", favorite);
-        bool ret = query.exec();
-        qDebug() << name << code << type << towards << latitude << longitude;
-        if (!ret) {
-            qDebug() << "***Adding " << name << " failed ***";
-            qDebug() << lastError();
-        }
-        return ret;
-    }
-    else {
-        qDebug() << "There is no db.";
-        return false;
+    StopRecord stop;
+    stop.code = code;
+    stop.latitude = latitude;
+    stop.longitude = longitude;
+    stop.name = name;
+    stop.stopPointIndicator = stopPointIndicator;
+    stop.towards = towards;
+    stop.type = type;
+    return addStops(QList<StopRecord>() << stop, favorite);
+}
+
+//queues a batch of stops for the executor, it writes them with a single upsert in one transaction
+//DatabaseExecutor::stopsAdded() tells when they are committed, returns false if they can't be written
+bool Database::addStops(const QList<StopRecord>& stops, bool favorite) {
+    if (!executor) { return false; }
+    executor->addStops(stops, favorite);
+    for (QList<StopRecord>::const_iterator iter = stops.begin(); iter != stops.end(); ++iter) {
+        queuedStops.insert(iter->code, *iter);
+        indexStop(*iter);
     }
+    return true;
 }
 
 //returns true if there are tubestations in stopstable
 bool Database::areTubeStationsInDB() {
-    if (createStopsTable()) {
-        QSqlQuery query;
-        bool ok = query.exec("SELECT * FROM stopstable WHERE type = 2");
-        if (!ok) {
-            qDebug() << lastError();
-            return true; //raise error
-        }
-        query.last();
-        if (query.at() < 0) { return false; }
-        else return true;
+    QSqlQuery query = readers.prepare("SELECT 1 FROM stopstable WHERE type = 2 LIMIT 1");
+    bool ok = query.exec();
+    if (!ok) {
+        qDebug() << query.lastError();
+        return true; //raise error
     }
-    else return true; //raise error
+    bool found = query.next();
+    query.finish();
+    return found;
 }
 
-//deletes every entry in stopstable that is not set to favorite by user and returns true if successful otherwise returns fasle
+//queues deleting every entry in stopstable that is not set to favorite by user for the executor,
+//returns false if it can't be done, DatabaseExecutor::stopsCleared() tells when it is done
 bool Database::clearStopsTable() {
-    QSqlQuery query;
-    bool ok = query.exec("DELETE FROM stopstable WHERE favorite=0");
-    return ok;
+    if (!executor) { return false; }
+    executor->clearStops();
+    return true;
 }
 
-bool Database::importStations() {
-    if (areTubeStationsInDB()) { return true; } //only need to import if we haven't got the data in our database
-    QString path = QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/stations.csv";
-    QFile file(path);
-    if (file.exists()) {
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qDebug() << "Error: stations.csv is not readable";
-        }
-        db.transaction();
-        while (!file.atEnd()) {
-            ///TODO Check for validity of file
-            QByteArray line =  file.readLine();
-            QList<QByteArray> lineList = line.split(';');
-            if (createStopsTable() && lineList.size() >= 6 ) {
-                QSqlQuery query;
-                query.prepare("INSERT INTO stopstable (name, code, type, latitude, longitude, favorite) "
-                              "VALUES (:name, :code, :type, :latitude, :longitude, :favorite)"
-                              );
-
-                if (lineList.at(0) == "name") continue; //skip first line
-                query.bindValue(":name",lineList.at(0));
-                QString code = lineList.at(1);
-                if (code == "") {
-                    //Null
-                    query.bindValue(":code",QVariant(QVariant::String));
-                }
-                else { query.bindValue(":code",code); }
-                query.bindValue(":type",lineList.at(2).toInt());
-                query.bindValue(":latitude",lineList.at(4));
-                query.bindValue(":longitude",lineList.at(5));
-                query.bindValue(":favorite", 0);
-                if (!query.exec()) {
-                    qDebug() << "Error: query failed, rolling back transaction" << lastError();
-                    db.rollback();
-                    return false;
-                }
-            }
-            else { qDebug() << "lineList.size()" << lineList.size(); }
-        }
-        db.commit();
-        qDebug() << "Stations imported";
-        return true;
+//forgets the stops that were written, indexes handed over from now on have them
+void Database::dropQueuedStops(const QStringList& codes) {
+    for (QStringList::const_iterator iter = codes.begin(); iter != codes.end(); ++iter) {
+        queuedStops.remove(*iter);
     }
-    else {
-        qDebug() << "Error: There is no CSV file located";
-        return false;
+}
+
+//returns the codes that are favorites in the order they were given, so that a view can ask about all of its stops at once
+QStringList Database::favoritesAmong(const QStringList& codes) const {
+    QStringList ret;
+    for (QStringList::const_iterator iter = codes.begin(); iter != codes.end(); ++iter) {
+        if (favorites.contains(*iter)) { ret << *iter; }
     }
+    return ret;
 }
 
-//checks if a given bus stop or pier(by their code) is favorite
-bool Database::isFavorite(const QString& code) const {
-    QSqlQuery query;
-    query.prepare("SELECT favorite FROM stopstable WHERE code= :code ");
-    query.bindValue(":code", code);
-    bool ok  = query.exec();
-    bool ret = false;
+DatabaseExecutor* Database::getExecutor() const { return executor; }
+
+//returns the codes of favorite bus stops and piers in the order of their rank
+QStringList Database::getFavorites() const {
+    QStringList codes;
+    QSqlQuery query = readers.prepare("SELECT code FROM stopstable WHERE favorite = 1 AND (type = 1 OR type = 3) ORDER BY rank");
+    bool ok = query.exec();
     if (!ok) {
-        qDebug() << "isFavorite() failed";
+        qDebug() << "getFavorites() failed" << query.lastError();
+        return codes;
     }
-    else {
-        query.next();
-        ret = query.value(0).toBool();
+    while (query.next()) {
+        codes << query.value(0).toString();
     }
+    return codes;
+}
 
-    return ret;
+//returns the read-only connection of the calling thread, queries run on it never wait for a write
+QSqlDatabase Database::getReader() const { return readers.connection(); }
+
+//queues the import of stations.csv for the executor unless there are tube stations in stopstable already,
+//returns false if it can't be imported, DatabaseExecutor::stationsImported() tells when it is finished
+bool Database::importStations() {
+    if (areTubeStationsInDB()) { return true; } //only need to import if we haven't got the data in our database
+    QString path = QStandardPaths::writableLocation(QStandardPaths::DataLocation) + "/stations.csv";
+    if (!QFile::exists(path)) {
+        qDebug() << "Error: There is no CSV file located";
+        return false;
+    }
+    if (!executor) { return false; }
+    executor->importStations(path);
+    return true;
+}
+
+//queues the import of a whole stop dataset from a csv file for the executor, see StopImporter,
+//returns false if it can't be imported, DatabaseExecutor::stopsImported() tells when it is finished
+bool Database::importStops(const QString& path) {
+    if (!executor) { return false; }
+    executor->importStops(path);
+    return true;
 }
 
+//answered by favorites without touching the db
+bool Database::isFavorite(const QString& code) const { return favorites.contains(code); }
+
 QSqlError Database::lastError() const { return db.lastError(); }
 
-//makes a stop a favorite and ranks it as 1st, returns true on success and false otherwise
-bool Database::makeFavorite(const QString& code) {
-    db.transaction();
-    QSqlQuery query, query_incr;
-    //incrementing all ranks so that fresh results stay on the top for better usability
-    bool query_incr_ok = query_incr.exec("UPDATE stopstable SET rank = rank + 1 ");
-    query.prepare("UPDATE stopstable SET favorite=1, rank= 1 WHERE code= :code ");
+//returns the last saved predictions of a stop that haven't arrived yet, etas are worked out with the current time
+QList<Vehicle> Database::loadArrivals(const QString& code) {
+    QList<Vehicle> vehicles;
+    QSqlQuery query = readers.prepare("SELECT id, line, destination, towards, platform, type, estimatedtime, clockoffset "
+                                      "FROM arrivalstable WHERE stopcode = :code");
     query.bindValue(":code", code);
-    bool query_ok = query.exec();
-    if (query_incr_ok && query_ok) {
-        db.commit();
-        qDebug() << code << "is now favorite with rank 1";
-        return true;
+    if (!query.exec()) {
+        qDebug() << "loadArrivals() failed" << query.lastError();
+        return vehicles;
     }
-    else{
-        qDebug() << "makeFavorite() failed." << lastError();
-        db.rollback();
-        return false;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (query.next()) {
+        Vehicle vehicle;
+        vehicle.id = query.value(0).toString();
+        vehicle.line = query.value(1).toString();
+        vehicle.destination = query.value(2).toString();
+        vehicle.towards = query.value(3).toString();
+        vehicle.platform = query.value(4).toString();
+        vehicle.type = query.value(5).toInt();
+        vehicle.estimatedTime = query.value(6).toDouble();
+        vehicle.clockOffset = query.value(7).toDouble();
+        if (vehicle.estimatedTime < now + vehicle.clockOffset) continue; //already gone
+        vehicle.updateEta();
+        vehicles << vehicle;
     }
+    return vehicles;
 }
 
+//queues making a stop a favorite ranked 1st for the executor, returns false if it can't be written
+//DatabaseExecutor::favoriteChanged() tells when it is done
+bool Database::makeFavorite(const QString& code) {
+    if (!executor) { return false; }
+    executor->makeFavorite(code);
+    return true;
+}
+
+//queues moving code1 to the place of code2 for the executor, code2 and the ones in between shift by one place
+//returns false if it can't be written, DatabaseExecutor::favoriteMoved() tells when it is done
 bool Database::move(const QString& code1, const QString& code2) {
-    int rank1 = getRank(code1);
-    int rank2 = getRank(code2);
+    qint64 rank1 = getRank(code1);
+    qint64 rank2 = getRank(code2);
     if (!rank1) {
         qDebug() << code1 << "is not favorite, move is temporary";
         return true;
     } //user moved an item that is not a favorite, don't do anything
-    db.transaction();
-    QSqlQuery query_list, query_move;
     if (!rank2) {//shouldn't be possible
         qDebug() << "Error: Moving" << code1 << "before an item that is not a favorite!";
+        return false;
     }
-    else {
-        if (rank1 > rank2) {
-            query_list.prepare("UPDATE stopstable SET rank = rank + 1 WHERE rank < :rank1 AND rank >= :rank2");
-        }
-        else {
-            query_list.prepare("UPDATE stopstable SET rank = rank - 1 WHERE rank > :rank1 AND rank <= :rank2");
-        }
-        query_list.bindValue(":rank1",rank1);
-        query_list.bindValue(":rank2",rank2);
-        query_move.prepare("UPDATE stopstable SET rank = :rank2 WHERE code = :code1");
-        query_move.bindValue(":rank2",rank2);
-        query_move.bindValue(":code1",code1);
-    }
-    bool list_ok = query_list.exec();
-    bool move_ok = query_move.exec();
-    if (list_ok && move_ok) { db.commit(); }
-    else {
-        qDebug() << "Moving failed: " << lastError();
-        db.rollback();
+    if (rank1 == rank2) { return true; }
+    if (!executor) { return false; }
+    executor->move(code1, code2);
+    return true;
+}
+
+//returns at most count stops closest to a point ordered by distance, type = -1 means any type of stop
+QList<StopIndex::Entry> Database::nearestStops(double latitude, double longitude, int count, int type) {
+    return stopIndex.nearest(latitude, longitude, count, type);
+}
+
+//queues the predictions of a stop for the executor that replaces the saved ones with them,
+//returns false if they can't be saved
+bool Database::saveArrivals(const QString& code, const QList<Vehicle>& vehicles) {
+    if (!executor) { return false; }
+    executor->saveArrivals(code, vehicles);
+    return true;
+}
+
+//returns the codes of at most limit stops whose name, towards or indicator has words starting with the words of text,
+//only stops of types are returned unless it is empty
+QStringList Database::searchStops(const QString& text, const QList<int>& types, int limit) {
+    return stopNameIndex.search(text, types, limit);
+}
+
+//takes the ranks of favorites written by the executor, see DatabaseExecutor::favoritesChanged()
+void Database::setFavorites(const QHash<QString,qint64>& ranks) { favorites = ranks; }
+
+//takes the indexes of stopstable built by the executor, see DatabaseExecutor::stopsIndexed(),
+//stops that are still queued are added to them
+void Database::setStopIndexes(const StopIndex& stops, const StopNameIndex& names) {
+    stopIndex = stops;
+    stopNameIndex = names;
+    for (QHash<QString,StopRecord>::const_iterator iter = queuedStops.begin(); iter != queuedStops.end(); ++iter) {
+        indexStop(*iter);
     }
+}
 
+//returns the stops inside a bounding box
+QList<StopIndex::Entry> Database::stopsWithin(double south, double west, double north, double east) {
+    return stopIndex.within(south, west, north, east);
+}
 
-    return list_ok && move_ok;
+//queues marking a stop as used now for the executor, so that it is evicted later
+void Database::touchStop(const QString& code) {
+    if (executor) { executor->touchStop(code); }
 }
 
-//makes a stop NOT favorite and decrements the ranks of other items to eliminate gaps,
-//returns true on success and false otherwise
+//queues making a stop NOT favorite for the executor, returns false if it can't be written
+//DatabaseExecutor::favoriteChanged() tells when it is done
 bool Database::unFavorite(const QString& code) {
-    db.transaction();
-    QSqlQuery query, query_dec;
-    query_dec.prepare("UPDATE stopstable SET rank= rank - 1 WHERE rank > :current");
-    query_dec.bindValue(":current", getRank(code));
-    query.prepare("UPDATE stopstable SET favorite=0, rank=NULL WHERE code= :code ");
-    query.bindValue(":code", code);
-    bool query_dec_ok = query_dec.exec();
-    bool query_ok = query.exec();
-    if (query_dec_ok && query_ok) {
-        db.commit();
-        return true;
-    }
-    else{
-        qDebug() << "unFavorite() failed." << lastError();
-        db.rollback();
-        return false;
-    }
+    if (!executor) { return false; }
+    executor->unFavorite(code);
+    return true;
 }
@@ -25,10 +25,24 @@ THE SOFTWARE.
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <QHash>
+#include <QList>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QStringList>
+#include "readerpool.h"
+#include "statementcache.h"
+#include "stopindex.h"
+#include "stopnameindex.h"
+#include "stoprecord.h"
+
+class DatabaseExecutor;
+class QThread;
+struct Vehicle;
 
 //This class is responsible to saving/retrieving all data that is required to/from an sqlite database on the device
+//The db is in WAL mode, reads go through the read-only connections of readers so they never wait for a write,
+//every write, the schema included, is run by the executor. db is read-only too.
 class Database
 {
 public:
@@ -36,26 +50,47 @@ public:
 public:
     ~Database();
 private:
-    QSqlDatabase db;
+    QSqlDatabase db;//read-only
+    DatabaseExecutor* executor;//lives on workerThread, 0 if db couldn't be opened
+    QHash<QString,qint64> favorites;//rank of every favorite by code, 0 if it has no rank yet, see setFavorites()
+    QHash<QString,StopRecord> queuedStops;//by code, indexed but not yet written by the executor
+    mutable ReaderPool readers;
+    mutable StatementCache statements;//of db
+    StopIndex stopIndex;//built by the executor, empty until it is handed over
+    StopNameIndex stopNameIndex;//handed over together with stopIndex
+    QThread* workerThread;
 private:
     void close();
     int countRanked() const;
-    bool createStopsTable();
-    int getRank(const QString& code) const;
-    bool isOpen() const;
-    bool isStopsTable() const;
+    qint64 getRank(const QString& code) const;
+    void indexStop(const StopRecord&);
+    bool loadFavorites();
     bool open();
-    bool upgrade();
 public:
     bool addStop(const QString& name,const QString& code,int type, QString& towards,double latitude, double longitude,
                  const QString& stopPointIndicator = QString(), bool favorite = false);
+    bool addStops(const QList<StopRecord>& stops, bool favorite = false);
     bool areTubeStationsInDB();
     bool clearStopsTable();
+    void dropQueuedStops(const QStringList& codes);
+    QStringList favoritesAmong(const QStringList& codes) const;
+    DatabaseExecutor* getExecutor() const;
+    QStringList getFavorites() const;
+    QSqlDatabase getReader() const;
     bool importStations();
+    bool importStops(const QString& path);
     bool isFavorite(const QString& code) const;
     QSqlError lastError() const; 
+    QList<Vehicle> loadArrivals(const QString& code);
     bool makeFavorite(const QString& code);
     bool move(const QString& code1, const QString& code2);
+    QList<StopIndex::Entry> nearestStops(double latitude, double longitude, int count, int type = -1);
+    bool saveArrivals(const QString& code, const QList<Vehicle>& vehicles);
+    QStringList searchStops(const QString& text, const QList<int>& types = QList<int>(), int limit = 100);
+    void setFavorites(const QHash<QString,qint64>& ranks);
+    void setStopIndexes(const StopIndex& stops, const StopNameIndex& names);
+    QList<StopIndex::Entry> stopsWithin(double south, double west, double north, double east);
+    void touchStop(const QString& code);
     bool unFavorite(const QString& code);
 };
 
@@ -0,0 +1,783 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "databaseexecutor.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QVariantList>
+#include "stopimporter.h"
+
+namespace {
+    const char* stopsTableColumns = "(name STRING, "
+                                    "code STRING UNIQUE, "
+                                    "type INTEGER, "
+                                    "towards STRING, "
+                                    "latitude REAL, "
+                                    "longitude REAL, "
+                                    "stoppointindicator STRING, "
+                                    "favorite INTEGER, "
+                                    "rank INTEGER)";
+    //favorites are ranked this far apart so that a stop can be put between two of them by changing its rank only
+    const qint64 rankGap = 1024;
+    //rank of the first favorite after renumbering, leaves room for as many new favorites on the top
+    const qint64 firstRank = rankGap * rankGap;
+}//end of unnamed namespace
+
+DatabaseExecutor::Job::Job() : favorite(false),
+                               kind(AddStops)
+{
+}
+
+DatabaseExecutor::DatabaseExecutor(const QString& p, QObject* parent) : QObject(parent),
+                                                                        cacheLimit(0),
+                                                                        connectionName("executor"),
+                                                                        importer(0),
+                                                                        path(p),
+                                                                        scheduled(false),
+                                                                        statements(connectionName)
+{
+}
+
+DatabaseExecutor::~DatabaseExecutor() {
+    statements.clear();
+    {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        if (db.isOpen()) { db.close(); }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+//private:
+//reads every stop into a spatial and a name index and hands them over with stopsIndexed(),
+//so that the gui never has to scan stopstable
+void DatabaseExecutor::buildIndexes() {
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT code, name, type, latitude, longitude, towards, stoppointindicator FROM stopstable")) {
+        qDebug() << "buildIndexes() failed" << query.lastError();
+        return;
+    }
+    StopIndex stopIndex;
+    StopNameIndex nameIndex;
+    while (query.next()) {
+        StopIndex::Entry entry;
+        entry.code = query.value(0).toString();
+        entry.name = query.value(1).toString();
+        entry.type = query.value(2).toInt();
+        bool latOk, lonOk;
+        entry.latitude = query.value(3).toDouble(&latOk);
+        entry.longitude = query.value(4).toDouble(&lonOk);
+        if (latOk && lonOk) { stopIndex.insert(entry); }
+        nameIndex.insert(entry.code, entry.type, entry.name, query.value(5).toString(), query.value(6).toString());
+    }
+    nameIndex.sort();
+    qDebug() << stopIndex.size() << "stops indexed";
+    emit stopsIndexed(stopIndex, nameIndex);
+}
+
+//creates arrivalstable that holds the last known predictions of stops,
+//returns true if it exists or was created otherwise returns false
+bool DatabaseExecutor::createArrivalsTable() {
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    bool ret = query.exec("CREATE TABLE IF NOT EXISTS arrivalstable "
+                          "(stopcode STRING, "
+                          "id STRING, "
+                          "line STRING, "
+                          "destination STRING, "
+                          "towards STRING, "
+                          "platform STRING, "
+                          "type INTEGER, "
+                          "estimatedtime REAL, "
+                          "clockoffset REAL)");
+    if (ret) { ret = query.exec("CREATE INDEX IF NOT EXISTS arrivalsstopcode ON arrivalstable (stopcode)"); }
+    if (!ret) { qDebug() << "createArrivalsTable() failed" << query.lastError(); }
+    return ret;
+}
+
+//creates stopstable unless it is present already, returns true if successful otherwise returns false
+bool DatabaseExecutor::createStopsTable() {
+    if (isStopsTable()) { return true; }
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    bool ret = query.exec(QString("CREATE TABLE stopstable ") + stopsTableColumns);
+    if (!ret) { qDebug() << "createStopsTable() failed" << query.lastError(); }
+    return ret;
+}
+
+//queues a job and makes sure that runJobs() is invoked on the thread of the executor
+void DatabaseExecutor::enqueue(const Job& job) {
+    QMutexLocker locker(&mutex);
+    jobs << job;
+    if (scheduled) return;
+    scheduled = true;
+    QMetaObject::invokeMethod(this, "runJobs", Qt::QueuedConnection);
+}
+
+//deletes the least recently used stops above cacheLimit in a transaction of its own,
+//returns how many were deleted or -1 if it failed
+int DatabaseExecutor::evictStops() {
+    int limit;
+    {
+        QMutexLocker locker(&mutex);
+        limit = cacheLimit;
+    }
+    if (limit <= 0) { return 0; }//there is no limit
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    db.transaction();
+    QSqlQuery query = statements.prepare("DELETE FROM stopstable WHERE code IN "
+                                         "(SELECT code FROM stopstable WHERE favorite = 0 AND lastused IS NOT NULL "
+                                         "ORDER BY lastused DESC LIMIT -1 OFFSET :limit)");
+    query.bindValue(":limit", limit);
+    if (!query.exec()) {
+        qDebug() << "evictStops() failed" << query.lastError();
+        db.rollback();
+        return -1;
+    }
+    int count = query.numRowsAffected();
+    db.commit();
+    if (count > 0) { qDebug() << count << "stops evicted"; }
+    return count;
+}
+
+//imports stations.csv unless there are tube stations in stopstable already, with a single prepared statement whose values are bound column by column
+//and written with one execBatch() inside a transaction, nothing is synced to disk until the import is finished
+bool DatabaseExecutor::importStationsFile(const QString& path) {
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    //an import queued earlier may have done it already
+    QSqlQuery check(db);
+    check.setForwardOnly(true);
+    if (check.exec("SELECT 1 FROM stopstable WHERE type = 2 LIMIT 1") && check.next()) { return true; }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Error: stations.csv is not readable";
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QVariantList names, codes, types, latitudes, longitudes;
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine());
+        //fields are located in place rather than split into a list
+        QStringRef fields[6];
+        int from = 0;
+        int field = 0;
+        for (; field != 6; ++field) {
+            int to = line.indexOf(';', from);
+            if (to < 0) break;
+            fields[field] = line.midRef(from, to - from);
+            from = to + 1;
+        }
+        if (field != 6) {
+            qDebug() << "Skipping line with too few fields" << line;
+            continue;
+        }
+        if (fields[0] == QLatin1String("name")) continue; //skip first line
+        names << fields[0].toString();
+        //Null
+        codes << (fields[1].isEmpty() ? QVariant(QVariant::String) : QVariant(fields[1].toString()));
+        types << fields[2].toString().toInt();
+        latitudes << fields[4].toString().toDouble();
+        longitudes << fields[5].toString().toDouble();
+    }
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA synchronous");
+    QVariant synchronous = pragma.next() ? pragma.value(0) : QVariant(2);
+    pragma.exec("PRAGMA synchronous = OFF");
+    db.transaction();
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO stopstable (name, code, type, latitude, longitude, favorite) "
+                  "VALUES (?, ?, ?, ?, ?, 0)");
+    query.addBindValue(names);
+    query.addBindValue(codes);
+    query.addBindValue(types);
+    query.addBindValue(latitudes);
+    query.addBindValue(longitudes);
+    bool ok = query.execBatch();
+    if (ok) { db.commit(); }
+    else {
+        qDebug() << "Error: query failed, rolling back transaction" << query.lastError();
+        db.rollback();
+    }
+    pragma.exec(QString("PRAGMA synchronous = ") + synchronous.toString());
+    if (!ok) { return false; }
+    qint64 elapsed = qMax(timer.elapsed(), qint64(1));
+    qDebug() << "Stations imported:" << names.size() << "rows in" << elapsed << "ms," << names.size() * 1000 / elapsed << "rows/s";
+    return true;
+}
+
+//returns true if stopstable is already present otherwise returns false
+//only the schema is looked at, the table itself isn't read
+bool DatabaseExecutor::isStopsTable() const { return QSqlDatabase::database(connectionName).tables().contains("stopstable"); }
+
+//fills favorites from stopstable, it is also used to undo the rank changes of jobs that were rolled back
+//returns false if stopstable couldn't be read
+bool DatabaseExecutor::loadFavorites() {
+    favorites.clear();
+    QSqlQuery query = statements.prepare("SELECT code, rank FROM stopstable WHERE favorite = 1");
+    if (!query.exec()) {
+        qDebug() << "loadFavorites() failed" << query.lastError();
+        return false;
+    }
+    while (query.next()) {
+        favorites.insert(query.value(0).toString(), query.value(1).toLongLong());
+    }
+    return true;
+}
+
+//brings the schema up to date by running every migration after the one recorded in PRAGMA user_version,
+//each one runs in its own transaction together with bumping the version, returns false if one failed
+//new migrations are appended to the list, the ones already released must never change
+bool DatabaseExecutor::migrate() {
+    typedef bool (DatabaseExecutor::*Migration)();
+    static const Migration migrations[] = {
+        &DatabaseExecutor::migrateToRealCoordinates, //1
+        &DatabaseExecutor::migrateToSparseRanks, //2
+        &DatabaseExecutor::migrateToLastUsed //3
+    };
+    const int latest = sizeof(migrations) / sizeof(migrations[0]);
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    for (int version = userVersion(); version < latest; ++version) {
+        db.transaction();
+        QSqlQuery query(db);
+        bool ok = (this->*migrations[version])() &&
+                  query.exec(QString("PRAGMA user_version = ") + QString::number(version + 1));
+        if (!ok) {
+            qDebug() << "Migration to version" << version + 1 << "failed." << db.lastError();
+            db.rollback();
+            return false;
+        }
+        db.commit();
+        qDebug() << "db migrated to version" << version + 1;
+    }
+    return true;
+}
+
+//version 3: stops remember when they were last used so that they can be evicted by evictStops(),
+//rows that are there already keep NULL and are never evicted, ie: stations and imported stops
+bool DatabaseExecutor::migrateToLastUsed() {
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    return query.exec("ALTER TABLE stopstable ADD COLUMN lastused INTEGER") &&
+           //eviction: WHERE favorite = 0 AND lastused IS NOT NULL ORDER BY lastused
+           query.exec("CREATE INDEX IF NOT EXISTS stopslastused ON stopstable (favorite, lastused)");
+}
+
+//version 1: coordinates are stored as REAL instead of strings and the columns that stop lists
+//filter and sort on are indexed, so listing favorites walks an index instead of sorting the table
+bool DatabaseExecutor::migrateToRealCoordinates() {
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    bool ok = true;
+    if (isStopsTable()) {
+        ok = query.exec(QString("CREATE TABLE stopstable_new ") + stopsTableColumns) &&
+             query.exec("INSERT INTO stopstable_new "
+                        "SELECT name, code, type, towards, CAST(latitude AS REAL), CAST(longitude AS REAL), "
+                        "stoppointindicator, favorite, rank FROM stopstable") &&
+             query.exec("DROP TABLE stopstable") &&
+             query.exec("ALTER TABLE stopstable_new RENAME TO stopstable");
+    }
+    else { ok = createStopsTable(); }
+    //favorite lists: WHERE favorite = 1 AND type = ? ORDER BY rank
+    return ok && query.exec("CREATE INDEX IF NOT EXISTS stopsfavorite ON stopstable (favorite, type, rank)") &&
+           //neighbours of a rank, see sparseRank()
+           query.exec("CREATE INDEX IF NOT EXISTS stopsrank ON stopstable (rank)") &&
+           //stations and other lists by type
+           query.exec("CREATE INDEX IF NOT EXISTS stopstype ON stopstable (type)");
+}
+
+//version 2: ranks of favorites are spread apart, see sparseRank()
+bool DatabaseExecutor::migrateToSparseRanks() { return renumberRanks(); }
+
+//gives favorites evenly spread ranks in their current order, it is only needed when two neighbours
+//have no rank left between them, it runs in the transaction of the job that needs it
+bool DatabaseExecutor::renumberRanks() {
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT code FROM stopstable WHERE rank IS NOT NULL ORDER BY rank")) { return false; }
+    QVariantList codes, ranks;
+    qint64 rank = firstRank;
+    while (query.next()) {
+        codes << query.value(0);
+        ranks << rank;
+        rank += rankGap;
+    }
+    if (codes.isEmpty()) { return true; }
+    QSqlQuery update(db);
+    update.prepare("UPDATE stopstable SET rank = ? WHERE code = ?");
+    update.addBindValue(ranks);
+    update.addBindValue(codes);
+    bool ok = update.execBatch();
+    //in case of a rollback favorites are loaded again
+    for (int i = 0; ok && i != codes.size(); ++i) {
+        favorites.insert(codes.at(i).toString(), ranks.at(i).toLongLong());
+    }
+    qDebug() << "Renumbered" << codes.size() << "favorites";
+    return ok;
+}
+
+//returns a free rank right before or after the favorite ranked anchor, halfway to its neighbour,
+//returns 0 if there is no room left and ranks need to be renumbered
+qint64 DatabaseExecutor::sparseRank(qint64 anchor, bool before) {
+    QSqlQuery query = statements.prepare(before ? "SELECT MAX(rank) FROM stopstable WHERE rank < :anchor"
+                                                : "SELECT MIN(rank) FROM stopstable WHERE rank > :anchor");
+    query.bindValue(":anchor", anchor);
+    qint64 neighbour = 0;
+    if (query.exec() && query.next()) { neighbour = query.value(0).toLongLong(); }
+    query.finish();
+    if (!neighbour) {
+        qint64 rank = before ? anchor - rankGap : anchor + rankGap;
+        return rank > 0 ? rank : 0;
+    }
+    qint64 rank = (anchor + neighbour) / 2;
+    return (rank == anchor || rank == neighbour) ? 0 : rank;
+}
+
+//renames the db of version 1.0 of the app to the one opened by open() after giving stopstable ranks,
+//returns false if there is one and it couldn't be upgraded
+bool DatabaseExecutor::upgrade() {
+    QString path_1 = QFileInfo(path).absolutePath() + "/data-1.0.sqlite";
+    QFile file_1(path_1);
+    if (!file_1.exists()) { return true; }
+    bool ok;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(path_1);
+        ok = db.open();
+        if (!ok) { qDebug() << "Couldn't open db 1.0."; }
+        else {
+            QSqlQuery query(db);
+            ok = query.exec("ALTER TABLE stopstable ADD COLUMN rank INTEGER");
+            if (!ok) {
+                qDebug() << "Upgrade from 1.0 failed." << query.lastError();
+            }
+            query.clear();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    if (!ok) { return false; }
+    bool rename_ok = file_1.rename(path);
+    if (!rename_ok) qDebug() << "Rename failed";
+    return rename_ok;
+}
+
+//returns the schema version recorded in the db file, 0 for a db that has never been migrated
+int DatabaseExecutor::userVersion() const {
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    if (!query.exec("PRAGMA user_version") || !query.next()) { return 0; }
+    return query.value(0).toInt();
+}
+
+//replaces the saved predictions of a stop, predictions of any stop that are long gone are dropped
+//so that the table doesn't grow
+bool DatabaseExecutor::writeArrivals(const Job& job) {
+    QSqlQuery query_del = statements.prepare("DELETE FROM arrivalstable WHERE stopcode = :code OR estimatedtime < :expired");
+    query_del.bindValue(":code", job.code);
+    query_del.bindValue(":expired", double(QDateTime::currentMSecsSinceEpoch() - 3600000));//an hour ago
+    bool ok = query_del.exec();
+    QSqlQuery query_ins = statements.prepare("INSERT INTO arrivalstable (stopcode, id, line, destination, towards, platform, type, "
+                                             "estimatedtime, clockoffset) "
+                                             "VALUES (:stopcode, :id, :line, :destination, :towards, :platform, :type, "
+                                             ":estimatedtime, :clockoffset)");
+    for (QList<Vehicle>::const_iterator iter = job.vehicles.begin(); ok && iter != job.vehicles.end(); ++iter) {
+        query_ins.bindValue(":stopcode", job.code);
+        query_ins.bindValue(":id", iter->id);
+        query_ins.bindValue(":line", iter->line);
+        query_ins.bindValue(":destination", iter->destination);
+        query_ins.bindValue(":towards", iter->towards);
+        query_ins.bindValue(":platform", iter->platform);
+        query_ins.bindValue(":type", iter->type);
+        query_ins.bindValue(":estimatedtime", iter->estimatedTime);
+        query_ins.bindValue(":clockoffset", iter->clockOffset);
+        ok = query_ins.exec();
+    }
+    if (!ok) { qDebug() << "saveArrivals() failed." << query_del.lastError() << query_ins.lastError(); }
+    return ok;
+}
+
+//deletes every stop that is not a favorite, stations and imported stops included
+bool DatabaseExecutor::writeClear() {
+    QSqlQuery query = statements.prepare("DELETE FROM stopstable WHERE favorite = 0");
+    bool ok = query.exec();
+    if (!ok) { qDebug() << "writeClear() failed" << query.lastError(); }
+    return ok;
+}
+
+//makes a stop a favorite and ranks it first, only the row of the stop is written unless ranks need renumbering
+//fails if the stop is not in db
+bool DatabaseExecutor::writeFavorite(const QString& code) {
+    qint64 first = 0;
+    for (Ranks::const_iterator iter = favorites.begin(); iter != favorites.end(); ++iter) {
+        if (*iter && (!first || *iter < first)) { first = *iter; }
+    }
+    bool ok = true;
+    //fresh results stay on the top for better usability
+    qint64 rank = first ? sparseRank(first, true) : firstRank;
+    if (!rank) {
+        ok = renumberRanks();
+        rank = firstRank - rankGap;
+    }
+    QSqlQuery query = statements.prepare("UPDATE stopstable SET favorite = 1, rank = :rank WHERE code = :code");
+    query.bindValue(":rank", rank);
+    query.bindValue(":code", code);
+    if (!ok || !query.exec()) {
+        qDebug() << "writeFavorite() failed" << query.lastError();
+        return false;
+    }
+    if (query.numRowsAffected() == 0) {
+        qDebug() << "writeFavorite()" << code << "is not in db";
+        return false;
+    }
+    favorites.insert(code, rank);
+    qDebug() << code << "is now favorite with rank" << rank;
+    return true;
+}
+
+//moves a favorite to the place of target, target and the ones in between shift by one place
+//only the rank of the moved one changes unless favorites need renumbering
+bool DatabaseExecutor::writeMove(const QString& code, const QString& target) {
+    qint64 rank1 = favorites.value(code, 0);
+    qint64 rank2 = favorites.value(target, 0);
+    if (!rank1 || !rank2) {
+        qDebug() << "Error: Moving" << code << "to the place of" << target << "but they are not both favorites!";
+        return false;
+    }
+    if (rank1 == rank2) { return true; }
+    bool up = rank1 > rank2;
+    bool ok = true;
+    qint64 rank = sparseRank(rank2, up);
+    if (!rank) {
+        ok = renumberRanks();
+        rank = sparseRank(favorites.value(target), up);
+    }
+    QSqlQuery query = statements.prepare("UPDATE stopstable SET rank = :rank WHERE code = :code");
+    query.bindValue(":rank", rank);
+    query.bindValue(":code", code);
+    if (!ok || !rank || !query.exec()) {
+        qDebug() << "writeMove() failed" << query.lastError();
+        return false;
+    }
+    favorites.insert(code, rank);
+    return true;
+}
+
+//upserts a batch of stops with two prepared statements run once each by execBatch(), stops in db already
+//get the details that were found and are marked as used now, the rest are inserted
+bool DatabaseExecutor::writeStops(const Job& job) {
+    QVariantList codes, favorites, indicators, lastUsed, latitudes, longitudes, names, towards, types;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (QList<StopRecord>::const_iterator iter = job.stops.begin(); iter != job.stops.end(); ++iter) {
+        codes << iter->code;
+        favorites << job.favorite;
+        indicators << iter->stopPointIndicator;
+        lastUsed << now;
+        latitudes << iter->latitude;
+        longitudes << iter->longitude;
+        names << iter->name;
+        towards << iter->towards;
+        types << iter->type;
+    }
+    //values are bound by position since the statements are reused, see StatementCache
+    QSqlQuery update = statements.prepare("UPDATE stopstable SET name = ?, type = ?, towards = ?, latitude = ?, longitude = ?, "
+                                          "stoppointindicator = ?, lastused = CASE WHEN lastused IS NULL THEN NULL ELSE ? END "
+                                          "WHERE code = ?");
+    update.bindValue(0, names);
+    update.bindValue(1, types);
+    update.bindValue(2, towards);
+    update.bindValue(3, latitudes);
+    update.bindValue(4, longitudes);
+    update.bindValue(5, indicators);
+    update.bindValue(6, lastUsed);
+    update.bindValue(7, codes);
+    QSqlQuery insert = statements.prepare("INSERT OR IGNORE INTO stopstable (name, code, type, towards, latitude, longitude, "
+                                          "stoppointindicator, favorite, lastused) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    insert.bindValue(0, names);
+    insert.bindValue(1, codes);
+    insert.bindValue(2, types);
+    insert.bindValue(3, towards);
+    insert.bindValue(4, latitudes);
+    insert.bindValue(5, longitudes);
+    insert.bindValue(6, indicators);
+    insert.bindValue(7, favorites);
+    insert.bindValue(8, lastUsed);
+    bool ok = update.execBatch() && insert.execBatch();
+    if (!ok) { qDebug() << "writeStops() failed" << update.lastError() << insert.lastError(); }
+    return ok;
+}
+
+//marks a stop as used now unless it is never evicted anyway
+bool DatabaseExecutor::writeTouch(const QString& code) {
+    QSqlQuery query = statements.prepare("UPDATE stopstable SET lastused = :now WHERE code = :code AND lastused IS NOT NULL");
+    query.bindValue(":now", QDateTime::currentMSecsSinceEpoch());
+    query.bindValue(":code", code);
+    bool ok = query.exec();
+    if (!ok) { qDebug() << "writeTouch() failed" << query.lastError(); }
+    return ok;
+}
+
+//makes a stop NOT favorite, ranks have gaps anyway so the others are left alone
+bool DatabaseExecutor::writeUnFavorite(const QString& code) {
+    QSqlQuery query = statements.prepare("UPDATE stopstable SET favorite = 0, rank = NULL WHERE code = :code");
+    query.bindValue(":code", code);
+    bool ok = query.exec();
+    if (!ok) { qDebug() << "writeUnFavorite() failed" << query.lastError(); }
+    else { favorites.remove(code); }
+    return ok;
+}
+
+//public:
+//the following functions are safe to call from any thread, they return as soon as the job is queued
+void DatabaseExecutor::addStops(const QList<StopRecord>& stops, bool favorite) {
+    Job job;
+    job.kind = Job::AddStops;
+    job.stops = stops;
+    job.favorite = favorite;
+    enqueue(job);
+}
+
+//stopsCleared() tells when it is done
+void DatabaseExecutor::clearStops() {
+    Job job;
+    job.kind = Job::ClearStops;
+    enqueue(job);
+}
+
+void DatabaseExecutor::importStations(const QString& path) {
+    Job job;
+    job.kind = Job::ImportStations;
+    job.path = path;
+    enqueue(job);
+}
+
+//see StopImporter
+void DatabaseExecutor::importStops(const QString& path) {
+    Job job;
+    job.kind = Job::ImportStops;
+    job.path = path;
+    enqueue(job);
+}
+
+//stopsIndexed() tells when it is done
+void DatabaseExecutor::indexStops() {
+    Job job;
+    job.kind = Job::IndexStops;
+    enqueue(job);
+}
+
+//favoriteChanged() tells when it is done
+void DatabaseExecutor::makeFavorite(const QString& code) {
+    Job job;
+    job.kind = Job::MakeFavorite;
+    job.code = code;
+    enqueue(job);
+}
+
+//favoriteMoved() tells when it is done
+void DatabaseExecutor::move(const QString& code, const QString& target) {
+    Job job;
+    job.kind = Job::Move;
+    job.code = code;
+    job.target = target;
+    enqueue(job);
+}
+
+void DatabaseExecutor::saveArrivals(const QString& code, const QList<Vehicle>& vehicles) {
+    Job job;
+    job.kind = Job::SaveArrivals;
+    job.code = code;
+    job.vehicles = vehicles;
+    enqueue(job);
+}
+
+//0 means no limit
+void DatabaseExecutor::setCacheLimit(int limit) {
+    QMutexLocker locker(&mutex);
+    cacheLimit = limit;
+}
+
+void DatabaseExecutor::touchStop(const QString& code) {
+    Job job;
+    job.kind = Job::TouchStop;
+    job.code = code;
+    enqueue(job);
+}
+
+//favoriteChanged() tells when it is done
+void DatabaseExecutor::unFavorite(const QString& code) {
+    Job job;
+    job.kind = Job::UnFavorite;
+    job.code = code;
+    enqueue(job);
+}
+
+//public slots:
+//opens the connection of the executor and brings the schema up to date, it has to run on the thread of the executor
+//nothing should read the db before it returns, returns false if the db can't be used
+bool DatabaseExecutor::open() {
+    importer = new StopImporter(this);
+    connect(importer, SIGNAL(progressChanged(int)), this, SIGNAL(importProgressChanged(int)) );
+    if (!upgrade()) { return false; }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(path);
+    //readers lock the db for a moment while they recover the wal
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open()) {
+        qDebug() << "Executor couldn't open db." << db.lastError();
+        return false;
+    }
+    //readers don't block the writer and the other way around, commits only sync at checkpoints
+    QSqlQuery query(db);
+    query.exec("PRAGMA journal_mode = WAL");
+    query.exec("PRAGMA synchronous = NORMAL");
+    if (!migrate() || !createArrivalsTable()) {
+        qDebug() << "Couldn't migrate db.";
+        return false;
+    }
+    loadFavorites();
+    return true;
+}
+
+//runs every job queued so far in the order they were queued, neighbouring writes share a transaction
+//imports have transactions of their own, stops are indexed again after those and after stops were deleted, favoritesChanged() is emitted after every transaction that wrote favorites
+void DatabaseExecutor::runJobs() {
+    QList<Job> taken;
+    {
+        QMutexLocker locker(&mutex);
+        taken.swap(jobs);
+        scheduled = false;
+    }
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    QList<Job>::const_iterator iter = taken.begin();
+    while (iter != taken.end()) {
+        if (iter->kind == Job::ImportStations) {
+            bool imported = importStationsFile(iter->path);
+            emit stationsImported(imported);
+            if (imported) { buildIndexes(); }
+            ++iter;
+            continue;
+        }
+        if (iter->kind == Job::ImportStops) {
+            bool imported = importer->import(db, iter->path);
+            emit stopsImported(imported);
+            if (imported) { buildIndexes(); }
+            ++iter;
+            continue;
+        }
+        if (iter->kind == Job::IndexStops) {
+            buildIndexes();
+            ++iter;
+            continue;
+        }
+        QStringList added;
+        QList<QPair<QString,bool> > favored;//codes made favorite or not favorite
+        QList<QPair<QString,bool> > moved;
+        QList<bool> cleared;
+        bool ranked = false;//favorites were written
+        bool ok = true;
+        db.transaction();
+        for (; iter != taken.end() && iter->kind != Job::ImportStations && iter->kind != Job::ImportStops &&
+               iter->kind != Job::IndexStops; ++iter) {
+            //a failed job is rolled back to its savepoint and only loses itself
+            QSqlQuery savepoint(db);
+            savepoint.exec("SAVEPOINT job");
+            bool done;
+            switch (iter->kind) {
+            case Job::AddStops:
+                done = writeStops(*iter);
+                ranked = ranked || iter->favorite;
+                break;
+            case Job::ClearStops:
+                done = writeClear();
+                cleared << done;
+                break;
+            case Job::MakeFavorite:
+                done = writeFavorite(iter->code);
+                ranked = true;
+                break;
+            case Job::Move:
+                done = writeMove(iter->code, iter->target);
+                moved << qMakePair(iter->code, done);
+                ranked = true;
+                break;
+            case Job::SaveArrivals:
+                done = writeArrivals(*iter);
+                break;
+            case Job::UnFavorite:
+                done = writeUnFavorite(iter->code);
+                ranked = true;
+                break;
+            default:
+                done = writeTouch(iter->code);
+            }
+            if (!done) {
+                savepoint.exec("ROLLBACK TO job");
+                ok = false;
+            }
+            else if (iter->kind == Job::AddStops) {
+                for (QList<StopRecord>::const_iterator stop = iter->stops.begin(); stop != iter->stops.end(); ++stop) {
+                    added << stop->code;
+                }
+            }
+            else if (iter->kind == Job::MakeFavorite || iter->kind == Job::UnFavorite) {
+                favored << qMakePair(iter->code, iter->kind == Job::MakeFavorite);
+            }
+            savepoint.exec("RELEASE job");
+        }
+        db.commit();
+        if (!ok) { qDebug() << "Some of the queued writes failed"; }
+        //the ranks of jobs that were rolled back are undone too, everybody gets them before the results
+        if (ranked) {
+            loadFavorites();
+            emit favoritesChanged(favorites);
+        }
+        for (QList<QPair<QString,bool> >::const_iterator favorite = favored.begin(); favorite != favored.end(); ++favorite) {
+            emit favoriteChanged(favorite->first, favorite->second);
+        }
+        for (QList<QPair<QString,bool> >::const_iterator drag = moved.begin(); drag != moved.end(); ++drag) {
+            emit favoriteMoved(drag->first, drag->second);
+        }
+        bool deleted = false;//the indexes have stops that are gone
+        for (QList<bool>::const_iterator clear = cleared.begin(); clear != cleared.end(); ++clear) {
+            emit stopsCleared(*clear);
+            deleted = deleted || *clear;
+        }
+        if (!added.isEmpty()) {
+            emit stopsAdded(added);
+            int evicted = evictStops();
+            if (evicted > 0) {
+                emit stopsEvicted(evicted);
+                deleted = true;
+            }
+        }
+        if (deleted) { buildIndexes(); }
+    }
+}
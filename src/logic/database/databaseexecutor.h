@@ -0,0 +1,135 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef DATABASEEXECUTOR_H
+#define DATABASEEXECUTOR_H
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "../arrivals/vehicle.h"
+#include "statementcache.h"
+#include "stopindex.h"
+#include "stopnameindex.h"
+#include "stoprecord.h"
+
+class StopImporter;
+
+//This class runs every write of Database, the schema included, on a thread of its own with the only connection
+//that writes, so that the gui never waits for one. Jobs can be queued from any thread, they are run in the order they were queued,
+//the ones queued together in a single transaction, and their results are reported through signals.
+//Favorites are ranked here, see writeFavorite() and writeMove(), the ranks are handed over with favoritesChanged().
+//The in-memory indexes of stops are built here too whenever stops are deleted or imported, see buildIndexes().
+//Stops found by searches are a cache, after they are written the least recently used ones above cacheLimit
+//are evicted. Favorites and rows without lastused (stations, imported stops) are never evicted.
+// !!! It has to be moved to its thread before open() is invoked !!!
+class DatabaseExecutor : public QObject
+{
+    Q_OBJECT
+public:
+    typedef QHash<QString,qint64> Ranks;//rank of every favorite by code, 0 if it has no rank yet
+    explicit DatabaseExecutor(const QString& path, QObject* parent = 0);
+    ~DatabaseExecutor();
+private:
+    struct Job {
+        enum Kind { AddStops, ClearStops, ImportStations, ImportStops, IndexStops, MakeFavorite, Move, SaveArrivals, TouchStop,
+                    UnFavorite };
+        Job();
+        QString code;
+        bool favorite;
+        int kind;
+        QString path;
+        QList<StopRecord> stops;
+        QString target;//code of the favorite whose place a moved one takes
+        QList<Vehicle> vehicles;
+    };
+    int cacheLimit;//of stops that can be evicted
+    QString connectionName;
+    Ranks favorites;//as they are in the transaction in progress, it is only used on the thread of the executor
+    StopImporter* importer;
+    QList<Job> jobs;
+    QMutex mutex;//guards cacheLimit, jobs and scheduled
+    QString path;
+    bool scheduled;//runJobs() has been invoked but hasn't taken the jobs yet
+    StatementCache statements;
+private:
+    void buildIndexes();
+    bool createArrivalsTable();
+    bool createStopsTable();
+    void enqueue(const Job&);
+    int evictStops();
+    bool importStationsFile(const QString& path);
+    bool isStopsTable() const;
+    bool loadFavorites();
+    bool migrate();
+    bool migrateToLastUsed();
+    bool migrateToRealCoordinates();
+    bool migrateToSparseRanks();
+    bool renumberRanks();
+    qint64 sparseRank(qint64 anchor, bool before);
+    bool upgrade();
+    int userVersion() const;
+    bool writeArrivals(const Job&);
+    bool writeClear();
+    bool writeFavorite(const QString& code);
+    bool writeMove(const QString& code, const QString& target);
+    bool writeStops(const Job&);
+    bool writeTouch(const QString& code);
+    bool writeUnFavorite(const QString& code);
+public:
+    void addStops(const QList<StopRecord>& stops, bool favorite = false);
+    void clearStops();
+    void importStations(const QString& path);
+    void importStops(const QString& path);
+    void indexStops();
+    void makeFavorite(const QString& code);
+    void move(const QString& code, const QString& target);
+    void saveArrivals(const QString& code, const QList<Vehicle>& vehicles);
+    void setCacheLimit(int);
+    void touchStop(const QString& code);
+    void unFavorite(const QString& code);
+signals:
+    void favoriteChanged(const QString& code, bool favorite);
+    void favoriteMoved(const QString& code, bool ok);
+    void favoritesChanged(const DatabaseExecutor::Ranks& ranks);
+    void importProgressChanged(int percent);
+    void stationsImported(bool ok);
+    void stopsAdded(const QStringList& codes);
+    void stopsCleared(bool ok);
+    void stopsEvicted(int count);
+    void stopsImported(bool ok);
+    void stopsIndexed(const StopIndex& stopIndex, const StopNameIndex& nameIndex);
+public slots:
+    bool open();
+    void runJobs();
+};
+
+Q_DECLARE_METATYPE(DatabaseExecutor::Ranks)
+
+#endif // DATABASEEXECUTOR_H
@@ -28,32 +28,107 @@ THE SOFTWARE.
 #include <QDebug>
 #include <QObject>
 #include <QVariant>
+#include "../arrivals/vehicle.h"
 
 
 DatabaseManager::DatabaseManager(QObject* parent) : QObject(parent)
 {
+    qRegisterMetaType<DatabaseExecutor::Ranks>("DatabaseExecutor::Ranks");
+    qRegisterMetaType<StopIndex>("StopIndex");
+    qRegisterMetaType<StopNameIndex>("StopNameIndex");
+    DatabaseExecutor* executor = db.getExecutor();
+    if (executor) {
+        connect(executor, SIGNAL(favoriteChanged(QString,bool)), this, SIGNAL(favoriteChanged(QString,bool)) );
+        connect(executor, SIGNAL(favoriteMoved(QString,bool)), this, SIGNAL(favoriteMoved(QString,bool)) );
+        connect(executor, SIGNAL(favoritesChanged(DatabaseExecutor::Ranks)), this, SLOT(onFavoritesChanged(DatabaseExecutor::Ranks)) );
+        connect(executor, SIGNAL(importProgressChanged(int)), this, SIGNAL(importProgressChanged(int)) );
+        connect(executor, SIGNAL(stationsImported(bool)), this, SIGNAL(stationsImported(bool)) );
+        connect(executor, SIGNAL(stopsAdded(QStringList)), this, SLOT(onStopsAdded(QStringList)) );
+        connect(executor, SIGNAL(stopsCleared(bool)), this, SIGNAL(stopsCleared(bool)) );
+        connect(executor, SIGNAL(stopsImported(bool)), this, SIGNAL(stopsImported(bool)) );
+        connect(executor, SIGNAL(stopsIndexed(StopIndex,StopNameIndex)), this, SLOT(onStopsIndexed(StopIndex,StopNameIndex)) );
+        //the executor rebuilds them by itself after stops are imported or deleted
+        executor->indexStops();
+    }
+}
+
+//private slots:
+//favorites are written by the executor, they are answered from its ranks from now on
+void DatabaseManager::onFavoritesChanged(const DatabaseExecutor::Ranks& ranks) {
+    db.setFavorites(ranks);
+    emit favoritesChanged();
+}
+
+//written stops are in the indexes handed over from now on
+void DatabaseManager::onStopsAdded(const QStringList& codes) {
+    db.dropQueuedStops(codes);
+    emit stopsAdded(codes);
+}
+
+//searches are answered from the indexes built by the executor, see DatabaseExecutor::stopsIndexed()
+void DatabaseManager::onStopsIndexed(const StopIndex& stops, const StopNameIndex& names) {
+    db.setStopIndexes(stops, names);
+    emit stopsIndexed();
 }
 
 //public:
-//adds a stop in DATA database, returns true on success and false otherwise
+//adds a stop in DATA database in the background, stopsAdded() is emitted once it is written
 bool DatabaseManager::addStop(const QString& name,const QString& code,int type, QString& towards, double latitude, double longitude,
              const QString& stopPointIndicator, bool favorite) {
     return db.addStop(name, code, type, towards, latitude, longitude, stopPointIndicator, favorite);
 }
 
+//adds a batch of stops in DATA database in the background, stopsAdded() is emitted once they are written
+bool DatabaseManager::addStops(const QList<StopRecord>& stops) { return db.addStops(stops); }
+
 bool DatabaseManager::areTubeStationsInDB() { return db.areTubeStationsInDB(); }
-//clears stopstable from unfavorited stops, returns true on success and false otherwise
+//clears stopstable from unfavorited stops in the background, stopsCleared() is emitted once it is done
 bool DatabaseManager::clearStopsTable() { return db.clearStopsTable(); }
 
+//returns which of the codes are favorites, it doesn't touch the db
+QStringList DatabaseManager::favoritesAmong(const QStringList& codes) const { return db.favoritesAmong(codes); }
+
+//returns the codes of favorite bus stops and piers ordered by rank
+QStringList DatabaseManager::getFavorites() const { return db.getFavorites(); }
+
+//returns a connection for queries of the calling thread that only read, ie: models
+QSqlDatabase DatabaseManager::getReader() const { return db.getReader(); }
+
 bool DatabaseManager::importStations() { return db.importStations(); }
 
-//checks if a stop is favorite
+//loads a complete stop dataset in the background, only rows that changed since the last import are written
+bool DatabaseManager::importStops(const QString& path) { return db.importStops(path); }
+
+//checks if a stop is favorite, it doesn't touch the db
 bool DatabaseManager::isFavorite(const QString& code) { return db.isFavorite(code); }
 
-//makes a stop favorite, returns true on success and false otherwise
+//returns the last known predictions of a stop that haven't arrived yet
+QList<Vehicle> DatabaseManager::loadArrivals(const QString& code) { return db.loadArrivals(code); }
+
+//makes a stop favorite in the background, favoriteChanged() is emitted once it is written
 bool DatabaseManager::makeFavorite(const QString& code) { return db.makeFavorite(code); }
 
+//moves a favorite to the place of another one in the background, favoriteMoved() is emitted once it is written
 bool DatabaseManager::move(const QString& from, const QString& to) { return db.move(from, to); }
 
-//makes a stop to be not favorite, returns true on success and false otherwise
+//returns at most count stops closest to a point ordered by distance, type = -1 means any type of stop
+QList<StopIndex::Entry> DatabaseManager::nearestStops(double latitude, double longitude, int count, int type) {
+    return db.nearestStops(latitude, longitude, count, type);
+}
+
+//saves the predictions of a stop so that they can be shown before the next download, returns true on success
+bool DatabaseManager::saveArrivals(const QString& code, const QList<Vehicle>& vehicles) { return db.saveArrivals(code, vehicles); }
+
+//returns the codes of stops in db matching text word by word, ie: "oxf ci" matches "Oxford Circus"
+QStringList DatabaseManager::searchStops(const QString& text, const QList<int>& types, int limit) { return db.searchStops(text, types, limit); }
+
+//returns the stops inside a bounding box given by its edges in degrees
+QList<StopIndex::Entry> DatabaseManager::stopsWithin(double south, double west, double north, double east) {
+    return db.stopsWithin(south, west, north, east);
+}
+
+//keeps a stop found by a search from being evicted for longer
+void DatabaseManager::touchStop(const QString& code) { db.touchStop(code); }
+
+//makes a stop to be not favorite in the background, favoriteChanged() is emitted once it is written
 bool DatabaseManager::unFavorite(const QString& code) { return db.unFavorite(code); }
@@ -25,28 +25,57 @@ THE SOFTWARE.
 #ifndef DATABASEMANAGER_H
 #define DATABASEMANAGER_H
 
+#include <QList>
 #include <QObject>
 #include "database.h"
+#include "databaseexecutor.h"
 
 class QSqlDatabase;
+struct Vehicle;
 
 //this class is to interact with different databases(data, settings, etc...`)
 class DatabaseManager : public QObject
 {
+    Q_OBJECT
 public:
     explicit DatabaseManager(QObject* parent = 0);
 private:
     Database db;
+private slots:
+    void onFavoritesChanged(const DatabaseExecutor::Ranks& ranks);
+    void onStopsAdded(const QStringList& codes);
+    void onStopsIndexed(const StopIndex& stops, const StopNameIndex& names);
 public:
     bool addStop(const QString& name,const QString& code,int type, QString& towards,double latitude, double longitude,
                  const QString& stopPointIndicator = QString(), bool favorite = false);
+    bool addStops(const QList<StopRecord>& stops);
     bool areTubeStationsInDB();
     bool clearStopsTable();
+    QStringList favoritesAmong(const QStringList& codes) const;
+    QStringList getFavorites() const;
+    QSqlDatabase getReader() const;
     bool importStations();
+    bool importStops(const QString& path);
     bool isFavorite(const QString& code);
+    QList<Vehicle> loadArrivals(const QString& code);
     bool makeFavorite(const QString& code);
     bool move(const QString& from, const QString& to);
+    QList<StopIndex::Entry> nearestStops(double latitude, double longitude, int count, int type = -1);
+    bool saveArrivals(const QString& code, const QList<Vehicle>& vehicles);
+    QStringList searchStops(const QString& text, const QList<int>& types = QList<int>(), int limit = 100);
+    QList<StopIndex::Entry> stopsWithin(double south, double west, double north, double east);
+    void touchStop(const QString& code);
     bool unFavorite(const QString& code);
+signals:
+    void favoriteChanged(const QString& code, bool favorite);
+    void favoriteMoved(const QString& code, bool ok);
+    void favoritesChanged();
+    void importProgressChanged(int percent);
+    void stationsImported(bool ok);
+    void stopsAdded(const QStringList& codes);
+    void stopsCleared(bool ok);
+    void stopsImported(bool ok);
+    void stopsIndexed();
 };
 
 #endif // DATABASEMANAGER_H
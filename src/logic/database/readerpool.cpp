@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "readerpool.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QThread>
+
+ReaderPool::ReaderPool()
+{
+}
+
+ReaderPool::~ReaderPool() {
+    for (QHash<QThread*,Reader*>::iterator iter = readers.begin(); iter != readers.end(); ++iter) {
+        QString name = (*iter)->connectionName;
+        delete *iter;//statements go before their connection
+        {
+            QSqlDatabase db = QSqlDatabase::database(name, false);
+            if (db.isOpen()) { db.close(); }
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+}
+
+//private:
+//returns the reader of the calling thread, it is opened if there is none yet
+//returns 0 until the path is set
+ReaderPool::Reader* ReaderPool::reader() {
+    QMutexLocker locker(&mutex);
+    if (path.isEmpty()) { return 0; }
+    QThread* thread = QThread::currentThread();
+    QHash<QThread*,Reader*>::const_iterator iter = readers.find(thread);
+    if (iter != readers.end()) { return *iter; }
+    Reader* reader = new Reader;
+    reader->connectionName = QString("reader-%1").arg(readers.size());
+    reader->statements.setConnectionName(reader->connectionName);
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", reader->connectionName);
+    db.setDatabaseName(path);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open()) { qDebug() << "ReaderPool: couldn't open a reader" << db.lastError(); }
+    readers.insert(thread, reader);
+    return reader;
+}
+
+//public:
+//returns the read-only connection of the calling thread, or the default connection if the pool has no path
+QSqlDatabase ReaderPool::connection() {
+    Reader* r = reader();
+    return r ? QSqlDatabase::database(r->connectionName) : QSqlDatabase::database();
+}
+
+//returns a cached statement of sql prepared on the connection of the calling thread, see StatementCache
+QSqlQuery ReaderPool::prepare(const QString& sql) {
+    Reader* r = reader();
+    if (r) { return r->statements.prepare(sql); }
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    return query;
+}
+
+void ReaderPool::setPath(const QString& value) {
+    QMutexLocker locker(&mutex);
+    path = value;
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef READERPOOL_H
+#define READERPOOL_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include "statementcache.h"
+
+class QThread;
+
+//This class hands out read-only connections to the db file, one for each thread that reads,
+//each with a StatementCache of its own. In WAL mode readers see the last commit and never wait for a writer.
+//Connections are opened on first use and closed when the pool is destroyed.
+// !!! A connection must only be used on the thread that got it !!!
+class ReaderPool
+{
+public:
+    ReaderPool();
+    ~ReaderPool();
+private:
+    struct Reader {
+        QString connectionName;
+        StatementCache statements;
+    };
+    QMutex mutex;//guards readers
+    QString path;
+    QHash<QThread*,Reader*> readers;
+private:
+    Reader* reader();
+public:
+    QSqlDatabase connection();
+    QSqlQuery prepare(const QString& sql);
+    void setPath(const QString&);
+};
+
+#endif // READERPOOL_H
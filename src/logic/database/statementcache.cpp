@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "statementcache.h"
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+
+StatementCache::StatementCache(const QString& name) : connectionName(name)
+{
+}
+
+//public:
+void StatementCache::clear() { statements.clear(); }
+
+//returns the statement of sql prepared on the connection, values bound by the previous run are left in place
+//a statement that couldn't be prepared isn't cached so that the error shows up again
+QSqlQuery StatementCache::prepare(const QString& sql) {
+    QHash<QString,QSqlQuery>::iterator iter = statements.find(sql);
+    if (iter != statements.end()) {
+        iter->finish();
+        return *iter;
+    }
+    QSqlQuery query(QSqlDatabase::database(connectionName, false));
+    query.setForwardOnly(true);
+    if (!query.prepare(sql)) {
+        qDebug() << "StatementCache: couldn't prepare" << sql << query.lastError();
+        return query;
+    }
+    statements.insert(sql, query);
+    return query;
+}
+
+//statements of the previous connection are dropped
+void StatementCache::setConnectionName(const QString& name) {
+    clear();
+    connectionName = name;
+}
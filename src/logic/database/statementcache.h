@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+
+//This class keeps the prepared statements of a connection keyed by their sql text,
+//so that queries run over and over are only parsed by sqlite once.
+//Statements are forward only and share their result with every copy handed out.
+// !!! It must only be used on the thread of its connection and cleared before the connection is closed !!!
+// !!! A statement whose rows are not all read has to be finish()ed, it holds a snapshot of the db until then !!!
+class StatementCache
+{
+public:
+    explicit StatementCache(const QString& connectionName = QLatin1String(QSqlDatabase::defaultConnection));
+private:
+    QString connectionName;
+    QHash<QString,QSqlQuery> statements;
+public:
+    void clear();
+    QSqlQuery prepare(const QString& sql);
+    void setConnectionName(const QString&);
+};
+
+#endif // STATEMENTCACHE_H
@@ -0,0 +1,214 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "stopimporter.h"
+#include <QDebug>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include "../arrivals/stop.h"
+
+namespace {
+    const int batchSize = 500;
+
+    //splits a line of csv, delimiters inside quotes are kept and doubled quotes are unescaped
+    QStringList splitLine(const QString& line, QChar delimiter) {
+        QStringList fields;
+        QString field;
+        bool quoted = false;
+        for (int i = 0; i != line.size(); ++i) {
+            QChar c = line.at(i);
+            if (c == '"') {
+                if (quoted && i + 1 != line.size() && line.at(i + 1) == '"') {
+                    field += c;
+                    ++i;
+                }
+                else { quoted = !quoted; }
+            }
+            else if (c == delimiter && !quoted) {
+                fields << field;
+                field.clear();
+            }
+            else { field += c; }
+        }
+        fields << field;
+        return fields;
+    }
+
+    //works out the type of a stop from either a Stop::Type or a NaPTAN stop type,
+    //returns Stop::None for stops that are not served by buses or boats
+    int stopType(const QString& value) {
+        bool isNumber = false;
+        int type = value.toInt(&isNumber);
+        if (isNumber) { return type; }
+        QString naptan = value.toUpper();
+        if (naptan == "BCT" || naptan == "BCS" || naptan == "BCQ" || naptan == "BST") { return Stop::Bus; }
+        if (naptan == "FER" || naptan == "FBT") { return Stop::River; }
+        return Stop::None;
+    }
+}//end of unnamed namespace
+
+StopImporter::StopImporter(QObject* parent) : QObject(parent),
+                                              progress(0),
+                                              rowsRead(0)
+{
+}
+
+//private:
+//releases the statements of the import and the values that were not written
+void StopImporter::finish() {
+    insert = QSqlQuery();
+    update = QSqlQuery();
+    codes.clear();
+    indicators.clear();
+    latitudes.clear();
+    longitudes.clear();
+    names.clear();
+    towards.clear();
+    types.clear();
+}
+
+//writes the rows read since the last call with the statements of prepare(), rows that changed are updated
+//and new ones are inserted, every other row is left untouched, returns false if a query failed
+bool StopImporter::flush() {
+    if (codes.isEmpty()) { return true; }
+    QVariantList values[] = { names, types, towards, indicators, latitudes, longitudes, codes,
+                              names, types, towards, indicators, latitudes, longitudes };
+    for (int i = 0; i != int(sizeof(values) / sizeof(values[0])); ++i) { update.bindValue(i, values[i]); }
+    insert.bindValue(0, codes);
+    insert.bindValue(1, names);
+    insert.bindValue(2, types);
+    insert.bindValue(3, towards);
+    insert.bindValue(4, indicators);
+    insert.bindValue(5, latitudes);
+    insert.bindValue(6, longitudes);
+    bool ok = update.execBatch() && insert.execBatch();
+    if (!ok) { qDebug() << "StopImporter: batch failed" << update.lastError() << insert.lastError(); }
+    codes.clear();
+    indicators.clear();
+    latitudes.clear();
+    longitudes.clear();
+    names.clear();
+    towards.clear();
+    types.clear();
+    return ok;
+}
+
+//prepares the statements every batch of an import is written with, returns false if they can't be prepared
+bool StopImporter::prepare(QSqlDatabase& db) {
+    update = QSqlQuery(db);
+    insert = QSqlQuery(db);
+    bool ok = update.prepare("UPDATE stopstable SET name = ?, type = ?, towards = ?, stoppointindicator = ?, latitude = ?, longitude = ? "
+                             "WHERE code = ? AND (name IS NOT ? OR type IS NOT ? OR towards IS NOT ? OR stoppointindicator IS NOT ? "
+                             "OR latitude IS NOT ? OR longitude IS NOT ?)") &&
+              insert.prepare("INSERT OR IGNORE INTO stopstable (code, name, type, towards, stoppointindicator, latitude, longitude, favorite) "
+                             "VALUES (?, ?, ?, ?, ?, ?, ?, 0)");
+    if (!ok) { qDebug() << "StopImporter: couldn't prepare statements" << update.lastError() << insert.lastError(); }
+    return ok;
+}
+
+//maps Column values to the index of fields, returns how many columns were found
+int StopImporter::readColumns(const QString& header, QChar delimiter, QHash<int,int>& columns) const {
+    QStringList fields = splitLine(header, delimiter);
+    for (int index = 0; index != fields.size(); ++index) {
+        QString field = fields.at(index).trimmed().toLower();
+        int column = -1;
+        if (field == "code" || field == "stopcode1" || field == "naptancode") { column = Code; }
+        else if (field == "name" || field == "stoppointname" || field == "commonname") { column = Name; }
+        else if (field == "type" || field == "stoptype") { column = Type; }
+        else if (field == "towards") { column = Towards; }
+        else if (field == "stoppointindicator" || field == "indicator") { column = Indicator; }
+        else if (field == "latitude") { column = Latitude; }
+        else if (field == "longitude") { column = Longitude; }
+        if (column != -1 && !columns.contains(column)) { columns.insert(column, index); }
+    }
+    return columns.size();
+}
+
+//public:
+int StopImporter::getProgress() const { return progress; }
+
+int StopImporter::getRowsRead() const { return rowsRead; }
+
+//imports every stop of the file that has a code and a known type, everything is rolled back if a batch fails
+//returns true on success and false otherwise
+bool StopImporter::import(QSqlDatabase& db, const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "StopImporter: couldn't open" << path;
+        return false;
+    }
+    rowsRead = 0;
+    progress = 0;
+    emit progressChanged(progress);
+    QString header = QString::fromUtf8(file.readLine()).trimmed();
+    QChar delimiter = header.count(';') > header.count(',') ? ';' : ',';
+    QHash<int,int> columns;
+    readColumns(header, delimiter, columns);
+    if (!columns.contains(Code) || !columns.contains(Name) || !columns.contains(Latitude) || !columns.contains(Longitude)) {
+        qDebug() << "StopImporter: missing columns in" << path;
+        return false;
+    }
+    if (!prepare(db)) { return false; }
+    qint64 size = qMax(file.size(), qint64(1));
+    db.transaction();
+    while (!file.atEnd()) {
+        QStringList fields = splitLine(QString::fromUtf8(file.readLine()).trimmed(), delimiter);
+        QString code = fields.value(columns.value(Code)).trimmed();
+        int type = columns.contains(Type) ? stopType(fields.value(columns.value(Type))) : int(Stop::Bus);
+        if (code.isEmpty() || type == Stop::None) continue;
+        codes << code;
+        names << fields.value(columns.value(Name));
+        types << type;
+        towards << (columns.contains(Towards) ? fields.value(columns.value(Towards)) : QString());
+        indicators << (columns.contains(Indicator) ? fields.value(columns.value(Indicator)) : QString());
+        latitudes << fields.value(columns.value(Latitude)).toDouble();
+        longitudes << fields.value(columns.value(Longitude)).toDouble();
+        ++rowsRead;
+        if (codes.size() == batchSize) {
+            if (!flush()) {
+                db.rollback();
+                finish();
+                return false;
+            }
+            int percent = file.pos() * 100 / size;
+            if (percent != progress) {
+                progress = percent;
+                emit progressChanged(progress);
+            }
+        }
+    }
+    bool ok = flush();
+    if (ok) { db.commit(); }
+    else { db.rollback(); }
+    finish();
+    if (!ok) { return false; }
+    progress = 100;
+    emit progressChanged(progress);
+    qDebug() << "StopImporter:" << rowsRead << "stops read from" << path;
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef STOPIMPORTER_H
+#define STOPIMPORTER_H
+
+#include <QHash>
+#include <QObject>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariantList>
+
+class QSqlDatabase;
+
+//This class loads a whole stop dataset from a csv file into stopstable, the file is read line by line
+//and rows are written in batches within a single transaction. Columns are found by the header so both
+//the layout of stopstable and NaPTAN-style files (NaptanCode, CommonName, Indicator, StopType...) are accepted.
+//Importing the same file again only writes the rows that changed, favorites and ranks are left alone.
+class StopImporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StopImporter(QObject* parent = 0);
+private:
+    enum Column { Code, Name, Type, Towards, Indicator, Latitude, Longitude, ColumnCount };
+    //bound values of the rows read since the last batch, one list per column
+    QVariantList codes;
+    QVariantList indicators;
+    QVariantList latitudes;
+    QVariantList longitudes;
+    QVariantList names;
+    QVariantList towards;
+    QVariantList types;
+    QSqlQuery insert;//prepared once per import, only the values are bound again for every batch
+    int progress;//percent of the file read
+    int rowsRead;
+    QSqlQuery update;//prepared like insert
+private:
+    void finish();
+    bool flush();
+    bool prepare(QSqlDatabase&);
+    int readColumns(const QString& header, QChar delimiter, QHash<int,int>& columns) const;
+public:
+    int getProgress() const;
+    int getRowsRead() const;
+    bool import(QSqlDatabase&, const QString& path);
+signals:
+    void progressChanged(int percent);
+};
+
+#endif // STOPIMPORTER_H
@@ -0,0 +1,163 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "stopindex.h"
+#include <cmath>
+
+namespace {
+    const double cellLatitude = 0.005;//~556m
+    const double cellLongitude = 0.008;//~554m at the latitude of London
+    const double cellMetres = 550;//the shorter side of a cell, rings are at least this far apart
+    const double earthRadius = 6371000;
+    const double pi = 3.14159265358979323846;
+}//end of unnamed namespace
+
+StopIndex::StopIndex() : maxColumn(0),
+                         maxRow(0),
+                         minColumn(0),
+                         minRow(0)
+{
+}
+
+//private:
+qint64 StopIndex::cellKey(int row, int column) { return (qint64(row) << 32) | quint32(column); }
+
+//adds the stops of a cell to found by their distance from the given point, type = -1 means any type
+void StopIndex::collect(QMultiMap<double,int>& found, int row, int column, double latitude, double longitude, int type) const {
+    QHash<qint64,QVector<int> >::const_iterator cell = cells.find(cellKey(row, column));
+    if (cell == cells.end()) return;
+    for (QVector<int>::const_iterator iter = cell->begin(); iter != cell->end(); ++iter) {
+        const Entry& entry = entries.at(*iter);
+        if (type != -1 && entry.type != type) continue;
+        found.insert(distance(latitude, longitude, entry.latitude, entry.longitude), *iter);
+    }
+}
+
+int StopIndex::columnOf(double longitude) { return std::floor(longitude / cellLongitude); }
+
+//returns the distance of two points in metres, equirectangular approximation is precise enough within a city
+double StopIndex::distance(double lat1, double lon1, double lat2, double lon2) {
+    double x = (lon2 - lon1) * pi / 180 * std::cos((lat1 + lat2) / 2 * pi / 180);
+    double y = (lat2 - lat1) * pi / 180;
+    return std::sqrt(x * x + y * y) * earthRadius;
+}
+
+int StopIndex::rowOf(double latitude) { return std::floor(latitude / cellLatitude); }
+
+//public:
+void StopIndex::clear() {
+    codes.clear();
+    cells.clear();
+    entries.clear();
+    maxColumn = maxRow = minColumn = minRow = 0;
+}
+
+//adds a stop to the index, returns false if a stop with the same code is already in it
+//or it is at 0/0, which is what feeds give for stops without a location
+bool StopIndex::insert(const Entry& entry) {
+    if (entry.latitude == 0 && entry.longitude == 0) { return false; }
+    if (!entry.code.isEmpty()) {
+        if (codes.contains(entry.code)) { return false; }
+        codes.insert(entry.code, entries.size());
+    }
+    int row = rowOf(entry.latitude);
+    int column = columnOf(entry.longitude);
+    if (entries.isEmpty()) {
+        minRow = maxRow = row;
+        minColumn = maxColumn = column;
+    }
+    else {
+        minRow = qMin(minRow, row);
+        maxRow = qMax(maxRow, row);
+        minColumn = qMin(minColumn, column);
+        maxColumn = qMax(maxColumn, column);
+    }
+    cells[cellKey(row, column)].append(entries.size());
+    entries.append(entry);
+    return true;
+}
+
+bool StopIndex::isEmpty() const { return entries.isEmpty(); }
+
+//returns at most count stops closest to the given point ordered by distance, type = -1 means any type
+//cells are visited in rings around the point until the ones left can't be closer than what was found,
+//only the part of a ring that overlaps the cells of stops is visited so a point far away costs no more than one nearby
+QList<StopIndex::Entry> StopIndex::nearest(double latitude, double longitude, int count, int type) const {
+    QList<Entry> ret;
+    if (entries.isEmpty() || count <= 0) { return ret; }
+    int row = rowOf(latitude);
+    int column = columnOf(longitude);
+    //rings before firstRing miss every stop, the ones after lastRing have none left
+    int firstRing = qMax(0, qMax(qMax(minRow - row, row - maxRow), qMax(minColumn - column, column - maxColumn)));
+    int lastRing = qMax(qMax(row - minRow, maxRow - row), qMax(column - minColumn, maxColumn - column));
+    QMultiMap<double,int> found;//distance -> index in entries
+    for (int ring = firstRing; ring <= lastRing; ++ring) {
+        for (int r = qMax(row - ring, minRow); r <= qMin(row + ring, maxRow); ++r) {
+            if (r == row - ring || r == row + ring) {
+                for (int c = qMax(column - ring, minColumn); c <= qMin(column + ring, maxColumn); ++c) {
+                    collect(found, r, c, latitude, longitude, type);
+                }
+            }
+            //inner cells of the ring have already been visited
+            else {
+                if (column - ring >= minColumn) { collect(found, r, column - ring, latitude, longitude, type); }
+                if (column + ring <= maxColumn) { collect(found, r, column + ring, latitude, longitude, type); }
+            }
+        }
+        //anything outside the visited rings is at least ring * cellMetres away
+        if (found.size() >= count) {
+            QMultiMap<double,int>::const_iterator last = found.begin() + (count - 1);
+            if (last.key() <= ring * cellMetres) { break; }
+        }
+    }
+    for (QMultiMap<double,int>::const_iterator iter = found.begin(); iter != found.end() && ret.size() < count; ++iter) {
+        ret << entries.at(iter.value());
+    }
+    return ret;
+}
+
+int StopIndex::size() const { return entries.size(); }
+
+//returns the stops inside a bounding box in no particular order
+QList<StopIndex::Entry> StopIndex::within(double south, double west, double north, double east) const {
+    QList<Entry> ret;
+    int firstRow = qMax(rowOf(south), minRow);
+    int lastRow = qMin(rowOf(north), maxRow);
+    int firstColumn = qMax(columnOf(west), minColumn);
+    int lastColumn = qMin(columnOf(east), maxColumn);
+    for (int r = firstRow; r <= lastRow; ++r) {
+        for (int c = firstColumn; c <= lastColumn; ++c) {
+            QHash<qint64,QVector<int> >::const_iterator cell = cells.find(cellKey(r, c));
+            if (cell == cells.end()) continue;
+            for (QVector<int>::const_iterator iter = cell->begin(); iter != cell->end(); ++iter) {
+                const Entry& entry = entries.at(*iter);
+                if (entry.latitude >= south && entry.latitude <= north && entry.longitude >= west && entry.longitude <= east) {
+                    ret << entry;
+                }
+            }
+        }
+    }
+    return ret;
+}
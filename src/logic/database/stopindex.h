@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef STOPINDEX_H
+#define STOPINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+//This class is an in-memory grid over the coordinates of stops to answer nearest-stop
+//and bounding box queries without scanning stopstable, each cell is roughly 550m x 550m in London
+class StopIndex
+{
+public:
+    struct Entry {
+        QString code;
+        QString name;
+        int type;
+        double latitude;
+        double longitude;
+    };
+    StopIndex();
+private:
+    QHash<QString,int> codes;//index in entries by code, stations without code are not in it
+    QHash<qint64,QVector<int> > cells;//indexes in entries by cell
+    QVector<Entry> entries;
+    int maxColumn;
+    int maxRow;
+    int minColumn;
+    int minRow;
+private:
+    static qint64 cellKey(int row, int column);
+    void collect(QMultiMap<double,int>& found, int row, int column, double latitude, double longitude, int type) const;
+    static int columnOf(double longitude);
+    static double distance(double lat1, double lon1, double lat2, double lon2);
+    static int rowOf(double latitude);
+public:
+    void clear();
+    bool insert(const Entry&);
+    bool isEmpty() const;
+    QList<Entry> nearest(double latitude, double longitude, int count, int type = -1) const;
+    int size() const;
+    QList<Entry> within(double south, double west, double north, double east) const;
+};
+
+Q_DECLARE_METATYPE(StopIndex)
+
+#endif // STOPINDEX_H
@@ -0,0 +1,121 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "stopnameindex.h"
+#include <QRegExp>
+#include <QSet>
+#include <QtAlgorithms>
+
+StopNameIndex::StopNameIndex() : sorted(true)
+{
+}
+
+//private:
+//returns the stops that have a word starting with prefix, sorts tokens first if stops were added since
+QVector<int> StopNameIndex::matching(const QString& prefix) const {
+    sort();
+    QVector<int> ret;
+    Token key;
+    key.text = prefix;
+    for (QVector<Token>::const_iterator iter = qLowerBound(tokens.constBegin(), tokens.constEnd(), key);
+         iter != tokens.constEnd() && iter->text.startsWith(prefix); ++iter) {
+        ret << iter->stop;
+    }
+    return ret;
+}
+
+//splits text into lower case words, punctuation is dropped
+QStringList StopNameIndex::tokenize(const QString& text) {
+    return text.toLower().split(QRegExp("[^\\w]+"), QString::SkipEmptyParts);
+}
+
+//public:
+void StopNameIndex::clear() {
+    codes.clear();
+    stops.clear();
+    tokens.clear();
+    stopTypes.clear();
+    sorted = true;
+}
+
+//adds the words of a stop to the index, returns false if the stop has no code or it is already in it
+bool StopNameIndex::insert(const QString& code, int type, const QString& name, const QString& towards, const QString& indicator) {
+    if (code.isEmpty() || stops.contains(code)) { return false; }
+    int stop = codes.size();
+    codes << code;
+    stopTypes << type;
+    stops.insert(code, stop);
+    QStringList words = tokenize(name) + tokenize(towards) + tokenize(indicator);
+    words.removeDuplicates();
+    for (QStringList::const_iterator iter = words.begin(); iter != words.end(); ++iter) {
+        Token token;
+        token.text = *iter;
+        token.stop = stop;
+        tokens << token;
+    }
+    sorted = false;
+    return true;
+}
+
+//returns the codes of at most limit stops that have a word starting with each word of text
+//ie: "oxf ci" finds "Oxford Circus", only stops of types are returned unless it is empty
+QStringList StopNameIndex::search(const QString& text, const QList<int>& types, int limit) const {
+    QStringList ret;
+    QStringList words = tokenize(text);
+    if (words.isEmpty()) { return ret; }
+    //the longest word is likely to match the fewest stops
+    QString longest = words.first();
+    for (QStringList::const_iterator iter = words.begin(); iter != words.end(); ++iter) {
+        if (iter->length() > longest.length()) { longest = *iter; }
+    }
+    QVector<int> candidates = matching(longest);
+    QSet<int> found;
+    for (QVector<int>::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter) {
+        if (types.isEmpty() || types.contains(stopTypes.at(*iter))) { found.insert(*iter); }
+    }
+    for (QStringList::const_iterator iter = words.begin(); iter != words.end() && !found.isEmpty(); ++iter) {
+        if (*iter == longest) continue;
+        QVector<int> matched = matching(*iter);
+        QSet<int> other;
+        for (QVector<int>::const_iterator stop = matched.begin(); stop != matched.end(); ++stop) {
+            other.insert(*stop);
+        }
+        found.intersect(other);
+    }
+    for (QSet<int>::const_iterator iter = found.begin(); iter != found.end() && ret.size() < limit; ++iter) {
+        ret << codes.at(*iter);
+    }
+    return ret;
+}
+
+int StopNameIndex::size() const { return codes.size(); }
+
+//sorts tokens unless they are sorted already, it is done by the first search otherwise
+//ie: an index built on another thread is sorted there
+void StopNameIndex::sort() const {
+    if (sorted) return;
+    qSort(tokens);
+    sorted = true;
+}
@@ -0,0 +1,67 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#ifndef STOPNAMEINDEX_H
+#define STOPNAMEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//This class is an in-memory prefix index over the words of the name, towards and indicator of stops
+//tokens are kept sorted so that every word starting with a prefix is found by a binary search
+//the type of every stop is kept too, so a search can be limited to some types of stops
+class StopNameIndex
+{
+public:
+    StopNameIndex();
+private:
+    struct Token {
+        QString text;
+        int stop;//index in codes
+        bool operator<(const Token& rhs) const { return text < rhs.text; }
+    };
+    QStringList codes;
+    QHash<QString,int> stops;//index in codes by code
+    QVector<int> stopTypes;//type of the stop by index in codes
+    mutable bool sorted;
+    mutable QVector<Token> tokens;
+private:
+    QVector<int> matching(const QString& prefix) const;
+    static QStringList tokenize(const QString&);
+public:
+    void clear();
+    bool insert(const QString& code, int type, const QString& name, const QString& towards, const QString& indicator);
+    QStringList search(const QString& text, const QList<int>& types = QList<int>(), int limit = 100) const;
+    int size() const;
+    void sort() const;
+};
+
+Q_DECLARE_METATYPE(StopNameIndex)
+
+#endif // STOPNAMEINDEX_H
@@ -27,14 +27,14 @@ THE SOFTWARE.
 #include <QDebug>
 #include <QDesktopServices>
 #include <QFile>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QRegExp>
 #include <QStandardPaths>
 #include <QStringList>
 #include "maps/busmapdownloader.h"
 #include "maps/mapfilesmodel.h"
 #include "maps/mapsmodel.h"
+#include "network/managedreply.h"
+#include "network/requestmanager.h"
 
 
 
@@ -42,8 +42,8 @@ THE SOFTWARE.
 MapLogic::MapLogic(QObject *parent) : QObject(parent),
                                       baseUrl("http://www.tfl.gov.uk/maps_/bus-spider-maps?Query="),
                                       downloading(false),
-                                      networkMngr(static_cast<QNetworkAccessManager*>(parent)),
-                                      mapDownloader(new BusMapDownloader(networkMngr)),
+                                      requestManager(static_cast<RequestManager*>(parent)),
+                                      mapDownloader(new BusMapDownloader(requestManager)),
                                       mapFilesModel(new MapFilesModel(this)),
                                       mapsModel(new MapsModel(&mapList,this)),
                                       reply(0)
@@ -159,7 +159,7 @@ void MapLogic::downloadListOfMapsFor(const QString& userInput) {
     QUrl url(request);
     downloading = true;
     emit downloadingChanged();
-    reply = networkMngr->get(QNetworkRequest(url));
+    reply = requestManager->get(url, RequestManager::Normal, "listOfMaps");
 
     connect(reply, SIGNAL(finished()),this, SLOT(onListOfMapsDownloaded()) );
 }
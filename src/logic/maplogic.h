@@ -31,11 +31,12 @@ THE SOFTWARE.
 
 class BusMapDownloader;
 class MapFilesModel;
+class ManagedReply;
 class MapsModel;
-class QNetworkAccessManager;
-class QNetworkReply;
+class RequestManager;
 
 //Class to handle downloading maps for GUI
+// !!! Parent MUST be a RequestManager or a nullptr !!!
 class MapLogic : public QObject
 {
     Q_OBJECT
@@ -44,12 +45,12 @@ public:
 private:
     QString baseUrl;
     bool downloading;
-    QNetworkAccessManager* networkMngr;
+    RequestManager* requestManager;
     BusMapDownloader* mapDownloader;
     QList<BusMap> mapList;
     MapFilesModel* mapFilesModel;
     MapsModel* mapsModel;
-    QNetworkReply* reply;
+    ManagedReply* reply;
 
 private:
     QString parseForLink(const QString&, int&);
@@ -27,15 +27,15 @@ THE SOFTWARE.
 #include <QDebug>
 #include <QDir>
 #include <QFile>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QStandardPaths>
+#include "../network/managedreply.h"
+#include "../network/requestmanager.h"
 
 BusMapDownloader::BusMapDownloader(QObject* parent) : QObject(parent),
                                                       baseUrl("https://www.tfl.gov.uk/cdn/static/cms/documents/bus-route-maps/"),
                                                       downloading(false),
-                                                      networkMngr(static_cast<QNetworkAccessManager*>(parent)),
                                                       reply(0),
+                                                      requestManager(static_cast<RequestManager*>(parent)),
                                                       running(false)
 {
     connect(this, SIGNAL(itemAdded()), this, SLOT(onItemAdded()) );
@@ -65,7 +65,8 @@ void BusMapDownloader::downloadMap(const BusMap& map) {
     currentMap = map;
     qDebug() << "downloading " << map.name;
 
-    reply = networkMngr->get(QNetworkRequest(QUrl(url)));
+    //maps are large, they must not hold up anything the user is waiting for
+    reply = requestManager->get(QUrl(url), RequestManager::Background);
     connect(reply, SIGNAL(finished()), this, SLOT(onMapDownloaded()) );
 }
 
@@ -29,10 +29,11 @@ THE SOFTWARE.
 #include <QQueue>
 #include "busmap.h"
 
-class QNetworkAccessManager;
-class QNetworkReply;
+class ManagedReply;
+class RequestManager;
 
 //Class to queue and download BusMap objects
+// !!! Parent MUST be a RequestManager or a nullptr !!!
 class BusMapDownloader : public QObject
 {
     Q_OBJECT
@@ -42,9 +43,9 @@ private:
     QString baseUrl;
     bool downloading;
     BusMap currentMap;
-    QNetworkAccessManager* networkMngr;
     QQueue<BusMap> queue;
-    QNetworkReply* reply;
+    ManagedReply* reply;
+    RequestManager* requestManager;
     bool running;//queue
 public:
     bool isDownloading() const;
@@ -0,0 +1,115 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "managedreply.h"
+#include <cstring>
+#include "requestmanager.h"
+
+namespace {
+//attributes of the underlying reply that are kept for the requesters
+const QNetworkRequest::Attribute keptAttributes[] = { QNetworkRequest::HttpStatusCodeAttribute,
+                                                      QNetworkRequest::HttpReasonPhraseAttribute,
+                                                      QNetworkRequest::RedirectionTargetAttribute };
+}//end of unnamed namespace
+
+ManagedReply::ManagedReply(const QUrl& url, int p, const QString& ch, RequestManager* parent) : QIODevice(parent),
+                                                                                              channel(ch),
+                                                                                              errorCode(QNetworkReply::NoError),
+                                                                                              finishedFlag(false),
+                                                                                              manager(parent),
+                                                                                              priority(p),
+                                                                                              requestUrl(url)
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+ManagedReply::~ManagedReply() {
+    if (manager && !finishedFlag) { manager->detach(this); }
+}
+
+//private:
+//adds data received by the transfer, readyRead() is not emitted for data replayed to a late requester
+//as nothing can be connected to it yet
+void ManagedReply::appendData(const QByteArray& data, bool notify) {
+    if (data.isEmpty()) return;
+    buffer += data;
+    if (notify) { emit readyRead(); }
+}
+
+//called by RequestManager when the request is superseded, no signals are emitted
+void ManagedReply::cancel() {
+    errorCode = QNetworkReply::OperationCanceledError;
+    setErrorString("Operation canceled");
+    finishedFlag = true;
+}
+
+//takes over the outcome of the transfer and notifies the requester
+void ManagedReply::finish(QNetworkReply* reply) {
+    errorCode = reply->error();
+    if (errorCode != QNetworkReply::NoError) { setErrorString(reply->errorString()); }
+    for (unsigned i = 0; i != sizeof(keptAttributes) / sizeof(keptAttributes[0]); ++i) {
+        QVariant value = reply->attribute(keptAttributes[i]);
+        if (value.isValid()) { attributes.insert(keptAttributes[i], value); }
+    }
+    finishedFlag = true;
+    emit finished();
+}
+
+//public:
+//stops waiting for the transfer, finished() is emitted with OperationCanceledError like QNetworkReply does
+void ManagedReply::abort() {
+    if (finishedFlag) return;
+    if (manager) { manager->detach(this); }
+    cancel();
+    emit finished();
+}
+
+QVariant ManagedReply::attribute(QNetworkRequest::Attribute code) const { return attributes.value(code); }
+
+qint64 ManagedReply::bytesAvailable() const { return buffer.size() + QIODevice::bytesAvailable(); }
+
+QNetworkReply::NetworkError ManagedReply::error() const { return errorCode; }
+
+QString ManagedReply::getChannel() const { return channel; }
+
+int ManagedReply::getPriority() const { return priority; }
+
+bool ManagedReply::isFinished() const { return finishedFlag; }
+
+bool ManagedReply::isSequential() const { return true; }
+
+//returns the url that was requested, not the one the transfer was redirected to
+QUrl ManagedReply::url() const { return requestUrl; }
+
+//protected:
+qint64 ManagedReply::readData(char* data, qint64 maxSize) {
+    qint64 size = qMin(maxSize, qint64(buffer.size()));
+    if (size <= 0) return 0;
+    std::memcpy(data, buffer.constData(), size);
+    buffer.remove(0, size);
+    return size;
+}
+
+//read only device
+qint64 ManagedReply::writeData(const char* /*data*/, qint64 /*maxSize*/) { return -1; }
@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef MANAGEDREPLY_H
+#define MANAGEDREPLY_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QString>
+#include <QUrl>
+#include <QVariant>
+
+class RequestManager;
+
+//Handle of a request issued through RequestManager, it can be read like a QNetworkReply
+//Requesters of the same url share one transfer, every handle buffers its own copy of the data
+//Deleting or aborting an unfinished handle detaches it, the transfer is aborted when nobody waits for it
+class ManagedReply : public QIODevice
+{
+    Q_OBJECT
+    friend class RequestManager;
+public:
+    ~ManagedReply();
+private:
+    explicit ManagedReply(const QUrl&, int priority, const QString& channel, RequestManager* parent);
+    QHash<int,QVariant> attributes;
+    QByteArray buffer;
+    QString channel;
+    QNetworkReply::NetworkError errorCode;
+    bool finishedFlag;
+    RequestManager* manager;
+    int priority;
+    QUrl requestUrl;
+private:
+    void appendData(const QByteArray&, bool notify);
+    void cancel();
+    void finish(QNetworkReply*);
+public:
+    void abort();
+    QVariant attribute(QNetworkRequest::Attribute) const;
+    qint64 bytesAvailable() const;
+    QNetworkReply::NetworkError error() const;
+    QString getChannel() const;
+    int getPriority() const;
+    bool isFinished() const;
+    bool isSequential() const;
+    QUrl url() const;
+protected:
+    qint64 readData(char* data, qint64 maxSize);
+    qint64 writeData(const char* data, qint64 maxSize);
+signals:
+    void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void finished();
+};
+
+#endif // MANAGEDREPLY_H
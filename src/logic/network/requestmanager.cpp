@@ -0,0 +1,250 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "requestmanager.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include "managedreply.h"
+
+namespace {
+//data of larger transfers is not kept for late requesters, they start a transfer of their own
+const int maxReplaySize = 512 * 1024;
+}//end of unnamed namespace
+
+// !!! See header for note on parent !!!
+RequestManager::RequestManager(QObject* parent) : QObject(parent),
+                                                  maxPerHost(4),
+                                                  networkMngr(static_cast<QNetworkAccessManager*>(parent))
+{
+}
+
+RequestManager::~RequestManager() {
+    //handles are children of this object, they must not call back while being deleted
+    for (QHash<ManagedReply*,Transfer*>::iterator iter = owners.begin(); iter != owners.end(); ++iter) {
+        iter.key()->manager = 0;
+    }
+    for (QHash<QNetworkReply*,Transfer*>::iterator iter = running.begin(); iter != running.end(); ++iter) {
+        disconnect(iter.key(), 0, this, 0);
+        delete iter.value();
+    }
+    qDeleteAll(queue);
+}
+
+//private:
+//makes a request the current one of its channel, the unfinished request it supersedes is deleted
+void RequestManager::claimChannel(ManagedReply* managedReply) {
+    QString channel = managedReply->getChannel();
+    if (channel.isEmpty()) return;
+    ManagedReply* superseded = channels.value(channel);
+    if (superseded) {
+        detach(superseded);
+        superseded->cancel();
+        superseded->deleteLater();
+    }
+    channels.insert(channel, managedReply);
+}
+
+//removes a requester from its transfer, the transfer is dropped if nobody else waits for it
+void RequestManager::detach(ManagedReply* managedReply) {
+    if (channels.value(managedReply->getChannel()) == managedReply) { channels.remove(managedReply->getChannel()); }
+    Transfer* transfer = owners.take(managedReply);
+    if (!transfer) return;
+    transfer->listeners.removeAll(managedReply);
+    if (transfer->listeners.isEmpty()) { dropTransfer(transfer); }
+}
+
+//takes a transfer out of the queue or aborts it if it is already running
+void RequestManager::dropTransfer(Transfer* transfer) {
+    QString key = transfer->url.toString();
+    if (transfers.value(key) == transfer) { transfers.remove(key); }
+    if (transfer->reply) {
+        running.remove(transfer->reply);
+        releaseHost(transfer);
+        disconnect(transfer->reply, 0, this, 0);
+        transfer->reply->abort();
+        transfer->reply->deleteLater();
+        delete transfer;
+        startNext();
+    }
+    else {
+        queue.removeAll(transfer);
+        delete transfer;
+    }
+}
+
+//inserts a transfer behind the ones with the same or higher priority
+void RequestManager::enqueue(Transfer* transfer) {
+    QList<Transfer*>::iterator iter = queue.begin();
+    while (iter != queue.end() && (*iter)->priority >= transfer->priority) { ++iter; }
+    queue.insert(iter, transfer);
+}
+
+//a finished or aborted transfer makes room for another one to the same host
+void RequestManager::releaseHost(Transfer* transfer) {
+    if (transfer->streaming) return;
+    if (--hostLoad[transfer->host] <= 0) { hostLoad.remove(transfer->host); }
+}
+
+//starts as many waiting transfers as the limit of their hosts allows
+void RequestManager::startNext() {
+    QList<Transfer*>::iterator iter = queue.begin();
+    while (iter != queue.end()) {
+        if (hostLoad.value((*iter)->host) < maxPerHost) {
+            Transfer* transfer = *iter;
+            iter = queue.erase(iter);
+            startTransfer(transfer);
+        }
+        else { ++iter; }
+    }
+}
+
+void RequestManager::startTransfer(Transfer* transfer) {
+    if (!networkMngr) return;
+    transfer->reply = networkMngr->get(QNetworkRequest(transfer->url));
+    running.insert(transfer->reply, transfer);
+    if (!transfer->streaming) { ++hostLoad[transfer->host]; }
+    connect(transfer->reply, SIGNAL(downloadProgress(qint64,qint64)), this, SLOT(onDownloadProgress(qint64,qint64)) );
+    connect(transfer->reply, SIGNAL(finished()), this, SLOT(onFinished()) );
+    connect(transfer->reply, SIGNAL(readyRead()), this, SLOT(onReadyRead()) );
+}
+
+//public:
+//requests a url, the returned handle is owned by the caller and should be deleted when finished
+//an unfinished request of the same channel is superseded and deleted without emitting any signals
+ManagedReply* RequestManager::get(const QUrl& url, int priority, const QString& channel) {
+    ManagedReply* managedReply = new ManagedReply(url, priority, channel, this);
+    QString key = url.toString();
+    Transfer* transfer = transfers.value(key);
+    if (transfer) {
+        managedReply->appendData(transfer->received, false);
+        //a foreground request must not wait behind background ones
+        if (!transfer->reply && priority > transfer->priority) {
+            queue.removeAll(transfer);
+            transfer->priority = priority;
+            enqueue(transfer);
+        }
+    }
+    else {
+        transfer = new Transfer;
+        transfer->host = url.host();
+        transfer->priority = priority;
+        transfer->reply = 0;
+        transfer->streaming = false;
+        transfer->url = url;
+        transfers.insert(key, transfer);
+        enqueue(transfer);
+    }
+    transfer->listeners.append(managedReply);
+    owners.insert(managedReply, transfer);
+
+    //the new request is attached first so that the transfer is kept if the superseded request shared it
+    claimChannel(managedReply);
+    startNext();
+    return managedReply;
+}
+
+int RequestManager::getMaxPerHost() const { return maxPerHost; }
+
+//sets the number of transfers that can run at the same time to a single host
+void RequestManager::setMaxPerHost(int value) {
+    maxPerHost = qMax(1, value);
+    startNext();
+}
+
+//opens a long lived request that delivers data as long as the server keeps sending it,
+//a stream is never shared with other requesters and starts regardless of the limit of its host
+ManagedReply* RequestManager::stream(const QUrl& url, const QString& channel) {
+    ManagedReply* managedReply = new ManagedReply(url, Foreground, channel, this);
+    Transfer* transfer = new Transfer;
+    transfer->host = url.host();
+    transfer->priority = Foreground;
+    transfer->reply = 0;
+    transfer->streaming = true;
+    transfer->url = url;
+    transfer->listeners.append(managedReply);
+    owners.insert(managedReply, transfer);
+    claimChannel(managedReply);
+    startTransfer(transfer);
+    return managedReply;
+}
+
+//private slots:
+void RequestManager::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal) {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    Transfer* transfer = running.value(reply);
+    if (!transfer) return;
+    QList<ManagedReply*> listeners = transfer->listeners;
+    for (QList<ManagedReply*>::const_iterator iter = listeners.begin(); iter != listeners.end(); ++iter) {
+        //a requester might have dropped the transfer in its slot
+        if (!running.contains(reply)) break;
+        if (owners.value(*iter) == transfer) { emit (*iter)->downloadProgress(bytesReceived, bytesTotal); }
+    }
+}
+
+//hands out the rest of the data and the outcome to every requester of the transfer
+void RequestManager::onFinished() {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    Transfer* transfer = running.take(reply);
+    if (!transfer) return;
+    releaseHost(transfer);
+    QString key = transfer->url.toString();
+    if (transfers.value(key) == transfer) { transfers.remove(key); }
+
+    QByteArray data = reply->readAll();
+    QList<ManagedReply*> listeners = transfer->listeners;
+    for (QList<ManagedReply*>::const_iterator iter = listeners.begin(); iter != listeners.end(); ++iter) {
+        owners.remove(*iter);
+        if (channels.value((*iter)->getChannel()) == *iter) { channels.remove((*iter)->getChannel()); }
+    }
+    delete transfer;
+    for (QList<ManagedReply*>::const_iterator iter = listeners.begin(); iter != listeners.end(); ++iter) {
+        (*iter)->appendData(data, false);
+        (*iter)->finish(reply);
+    }
+    reply->deleteLater();
+    startNext();
+}
+
+//copies the data that arrived to every requester of the transfer
+void RequestManager::onReadyRead() {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    Transfer* transfer = running.value(reply);
+    if (!transfer) return;
+    QByteArray data = reply->readAll();
+    QString key = transfer->url.toString();
+    if (transfers.value(key) == transfer) {
+        if (transfer->received.size() + data.size() > maxReplaySize) {
+            transfers.remove(key);
+            transfer->received.clear();
+        }
+        else { transfer->received += data; }
+    }
+    QList<ManagedReply*> listeners = transfer->listeners;
+    for (QList<ManagedReply*>::const_iterator iter = listeners.begin(); iter != listeners.end(); ++iter) {
+        //a requester might have dropped the transfer in its slot
+        if (!running.contains(reply)) break;
+        if (owners.value(*iter) == transfer) { (*iter)->appendData(data, true); }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef REQUESTMANAGER_H
+#define REQUESTMANAGER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+class ManagedReply;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+//Every download of the application goes through this class to the shared QNetworkAccessManager
+//Identical urls in flight are only downloaded once and handed out to each requester,
+//a request issued on a channel supersedes the unfinished request of the same channel and
+//waiting requests are started highest priority first with a limit on concurrent transfers per host,
+//long lived streams are started straight away and are not counted towards the limit
+// !!! Parent MUST be a QNetworkAccessManager or a nullptr !!!
+class RequestManager : public QObject
+{
+    Q_OBJECT
+    friend class ManagedReply;
+public:
+    enum Priority { Background, Normal, Foreground };
+    explicit RequestManager(QObject* parent = 0);
+    ~RequestManager();
+private:
+    //a single download shared by the requesters of the same url
+    struct Transfer {
+        QString host;
+        QList<ManagedReply*> listeners;
+        int priority;
+        QByteArray received;//replayed to requesters that join late
+        QNetworkReply* reply;//0 while waiting in queue
+        bool streaming;
+        QUrl url;
+    };
+    QHash<QString,ManagedReply*> channels;//the last request of each channel
+    QHash<QString,int> hostLoad;//number of running transfers by host
+    int maxPerHost;
+    QNetworkAccessManager* networkMngr;
+    QHash<ManagedReply*,Transfer*> owners;
+    QList<Transfer*> queue;//waiting transfers ordered by priority
+    QHash<QNetworkReply*,Transfer*> running;
+    QHash<QString,Transfer*> transfers;//transfers that can still be joined by url
+private:
+    void claimChannel(ManagedReply*);
+    void detach(ManagedReply*);
+    void dropTransfer(Transfer*);
+    void enqueue(Transfer*);
+    void releaseHost(Transfer*);
+    void startNext();
+    void startTransfer(Transfer*);
+public:
+    ManagedReply* get(const QUrl&, int priority = Normal, const QString& channel = QString());
+    int getMaxPerHost() const;
+    void setMaxPerHost(int);
+    ManagedReply* stream(const QUrl&, const QString& channel = QString());
+private slots:
+    void onDownloadProgress(qint64,qint64);
+    void onFinished();
+    void onReadyRead();
+};
+
+#endif // REQUESTMANAGER_H
@@ -24,9 +24,6 @@ THE SOFTWARE.
 
 #include "servicestatuslogic.h"
 #include <QDebug>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
 #include <QUrl>
 #include <QVariant>
 #include <QXmlInputSource>
@@ -34,6 +31,8 @@ THE SOFTWARE.
 #include "serviceStatus/servicestatusxmlhandler.h"
 #include "serviceStatus/thisweekendlinemodel.h"
 #include "serviceStatus/servicestatusproxymodel.h"
+#include "network/managedreply.h"
+#include "network/requestmanager.h"
 
 
 //BUG When the internet connection fails after the first call to ServiceStatusLogic::refresh()
@@ -44,8 +43,9 @@ ServiceStatusLogic::ServiceStatusLogic(QObject *parent) :
     QObject(parent),
     downloading(false),
     model(new ServiceStatusModel(this)),
-    networkMngr(static_cast<QNetworkAccessManager*>(parent)),
     proxyModel(new ServiceStatusProxyModel(this)),
+    reply(0),
+    requestManager(static_cast<RequestManager*>(parent)),
     url("http://cloud.tfl.gov.uk/TrackerNet/LineStatus") // /IncidentsOnly //add this later to improve network usage
 {
     proxyModel->setSourceModel(model);
@@ -94,9 +94,10 @@ bool ServiceStatusLogic::isDownloading() { return downloading; }
 void ServiceStatusLogic::refresh() {
     downloading = true;
     emit stateChanged();
-    if (networkMngr) {
+    if (requestManager) {
         if (model) { model->reset(); }
-        reply = networkMngr->get(QNetworkRequest(url));
+        //a refresh still in flight is superseded
+        reply = requestManager->get(url, RequestManager::Normal, "serviceStatus");
+        connect(reply, SIGNAL(finished()), this, SLOT(downloaded()) );
     }
-    connect(reply, SIGNAL(finished()), this, SLOT(downloaded()) );
 }
@@ -32,17 +32,17 @@ THE SOFTWARE.
 #include <QUrl>
 #include <QVariant>
 
-class QNetworkAccessManager;
-class QNetworkReply;
+class ManagedReply;
 class QString;
 class QXmlSimpleReader;
+class RequestManager;
 class ThisWeekendLineModel;
 class ServiceStatusProxyModel;
 
 //ServiceStatusLogic is responsible for fetching, parsing the data required to display Service Status information
 //it is also responsible of notifying ServiceStatusPage.qml when the data is ready to be displayed
 
-// !!! parent MUST be a NetworkAccessManager or a nullptr !!!
+// !!! parent MUST be a RequestManager or a nullptr !!!
 class ServiceStatusLogic : public QObject
 {
     Q_OBJECT
@@ -57,9 +57,9 @@ signals:
 private:
     bool downloading;
     ServiceStatusModel* model;
-    QNetworkAccessManager* networkMngr;//handle for global obj
     ServiceStatusProxyModel* proxyModel;
-    QNetworkReply* reply;//handled by this class
+    ManagedReply* reply;//handled by this class
+    RequestManager* requestManager;//handle for global obj
     QUrl url;
 private:
     QByteArray getData();
@@ -24,10 +24,10 @@ THE SOFTWARE.
 
 #include "thisweekendlogic.h"
 #include <QDebug>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QXmlSimpleReader>
 
+#include "network/managedreply.h"
+#include "network/requestmanager.h"
 #include "serviceStatus/servicestatusproxymodel.h"
 #include "serviceStatus/thisweekendxmlhandler.h"
 #include "serviceStatus/thisweekendlinemodel.h"
@@ -36,8 +36,9 @@ ThisWeekendLogic::ThisWeekendLogic(QObject *parent) :
     QObject(parent),
     downloading(false),
     model(new ThisWeekendLineModel(this)),
-    networkMngr(static_cast<QNetworkAccessManager*>(parent)),
     proxyModel(new ServiceStatusProxyModel(this)),
+    reply(0),
+    requestManager(static_cast<RequestManager*>(parent)),
     url("http://www.tfl.gov.uk/tfl/businessandpartners/syndication/feed.aspx?email=fasza2mobile@gmail.com&feedId=7")
 {
     proxyModel->setSourceModel(model);
@@ -84,11 +85,11 @@ bool ThisWeekendLogic::isDownloading() { return downloading; }
 //This slot called from GUI to get data displayed
 //TODO log nullptr
 void ThisWeekendLogic::refresh() {
-    if (networkMngr) {
+    if (requestManager) {
         if (model) { model->reset(); }
         downloading = true;
         emit stateChanged();
-        reply = networkMngr->get(QNetworkRequest(url));//will be deleted later
+        reply = requestManager->get(url, RequestManager::Normal, "thisWeekend");//will be deleted later
         connect(reply, SIGNAL(finished()), this, SLOT(downloaded()) );
     }
 }
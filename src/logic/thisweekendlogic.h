@@ -29,12 +29,12 @@ THE SOFTWARE.
 #include <QObject>
 #include <QUrl>
 
-class QNetworkAccessManager;
-class QNetworkReply;
+class ManagedReply;
+class RequestManager;
 class ServiceStatusProxyModel;
 class ThisWeekendLineModel;
 
-// !!! parent must be a NetworkAccessManager or nullptr(default)
+// !!! parent must be a RequestManager or nullptr(default)
 //This class is the logic behind "This Weekend/Weekend Disruption" feature
 class ThisWeekendLogic : public QObject
 {
@@ -44,9 +44,9 @@ public:
 private:
     bool downloading;
     ThisWeekendLineModel* model;//Qt memory management
-    QNetworkAccessManager* networkMngr;//just a handle for global QNetworkAccessManager
     ServiceStatusProxyModel* proxyModel;
-    QNetworkReply* reply;//handled in class
+    ManagedReply* reply;//handled in class
+    RequestManager* requestManager;//just a handle for global RequestManager
     QUrl url;
 private:
     void parseData(const QByteArray&);
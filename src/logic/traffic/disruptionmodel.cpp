@@ -33,7 +33,7 @@ DisruptionModel::DisruptionModel(QObject* c) : container(static_cast<TrafficCont
 }
 
 //informs model that we're about to add new items to our underlying container
-void DisruptionModel::beginInsert(int rows) { beginInsertRows(QModelIndex(),0,rows);}
+void DisruptionModel::beginInsert(int first, int last) { beginInsertRows(QModelIndex(),first,last);}
 
 //informs model that whatever is in the model is to be invalid
 void DisruptionModel::beginReset() { beginResetModel();}
@@ -43,7 +43,7 @@ public:
 private:
     TrafficContainer* container;
 public:
-    void beginInsert(int rows);
+    void beginInsert(int first, int last);
     void beginReset();
     virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
     void endInsert();
@@ -49,16 +49,23 @@ QList<Street>* TrafficContainer::getStreetsList(int id) {
 }
 
 //public:
-//this should not be used direcly whilst connected to a model, see this->swap()
-void TrafficContainer::addDisruption(const Disruption& item) {
-    disruptions << item;
+//adds the disruptions of a batch after the ones already shown, so that they are shown while the rest is parsed
+void TrafficContainer::append(const Batch& batch) {
+    if (!batch.disruptions.isEmpty()) {
+        disruptionModel->beginInsert(disruptions.size(), disruptions.size() + batch.disruptions.size() - 1);
+        disruptions << batch.disruptions;
+        disruptionModel->endInsert();
+    }
+    //don't need to reset model as it will not become invalid until new model is requested
+    streets.unite(batch.streets);
 }
 
-//this should not be used direcly whilst connected to a model, see this->swap()
-void TrafficContainer::addStreet(int id, const Street& street) {
-    if (id) {
-        streets.insertMulti(id,street);
-    }
+//removes every disruption and street
+void TrafficContainer::clear() {
+    disruptionModel->beginReset();
+    disruptions.clear();
+    disruptionModel->endReset();
+    streets.clear();
 }
 
 //returns a list of all Disruption objects
@@ -82,18 +89,3 @@ StreetModel* TrafficContainer::getStreetModel(int id) {
 
 //returns the amount of Distruption objects
 int TrafficContainer::size() { return disruptions.size(); }
-
-//swaps the data in the two containers, it is used so that user has always data to be displayed
-//after the initial download/parse
-void TrafficContainer::swap(TrafficContainer& other) {
-    disruptionModel->beginReset();
-    disruptions.clear();
-    disruptionModel->endReset();
-
-    disruptionModel->beginInsert(other.size()-1);//row numbers start with 0
-    disruptions.swap(other.disruptions);
-    disruptionModel->endInsert();
-
-    //don't need to reset model as it will not become invalid until new model is requested
-    streets.swap(other.streets);
-}
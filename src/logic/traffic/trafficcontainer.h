@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #include <QHash>
 #include <QList>
+#include <QMetaType>
 #include <QObject>
 #include "disruption.h"
 #include "street.h"
@@ -43,6 +44,11 @@ class TrafficContainer : public QObject
     Q_OBJECT
 public:
     explicit TrafficContainer(QObject *parent = 0);
+    //disruptions and their streets parsed from a part of the feed, see TrafficXmlReader
+    struct Batch {
+        QList<Disruption> disruptions;
+        QHash<int,Street> streets;//more than one for an id
+    };
 private:
     QList<Disruption> disruptions;
     DisruptionModel* disruptionModel;//Qt memory management
@@ -52,17 +58,18 @@ private:
 private:
     QList<Street>* getStreetsList(int id);
 public:
-    void addDisruption(const Disruption&);
-    void addStreet(int id, const Street& street);
+    void append(const Batch&);
+    void clear();
     QList<Disruption> getDisruptionList();
     DisruptionProxyModel* getDisruptionModel();
     StreetModel* getStreetModel(int id);
     int size();
-    void swap(TrafficContainer& other);
 signals:
 
 public slots:
 
 };
 
+Q_DECLARE_METATYPE(TrafficContainer::Batch)
+
 #endif // TRAFFICCONTAINER_H
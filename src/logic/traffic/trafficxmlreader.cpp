@@ -28,123 +28,139 @@ THE SOFTWARE.
 #include <QRegExp>
 #include "trafficcontainer.h"
 
-TrafficXmlReader::TrafficXmlReader(QObject* c) : container(static_cast<TrafficContainer*>(c)),
-                                                          currentID(0),
-                                                          inDisruption(false),
-                                                          inPoint(false),
-                                                          inStreet(false)
+namespace {
+    //replaces ',' with ", " if not followed by a whitespace, happends many times due to lousy typing
+    //it is to make WordWrap possible in gui
+    QString spaceCommas(QString value) {
+        int i;
+        while ((i = value.indexOf(QRegExp(",[^\\s-]"))) != -1 ) {
+            value = value.insert(++i, " ");
+        }
+        return value;
+    }
+}//end of unnamed namespace
+
+TrafficXmlReader::TrafficXmlReader(QObject* parent) : QObject(parent),
+                                                      currentID(0),
+                                                      done(false),
+                                                      inDisruption(false),
+                                                      inPoint(false),
+                                                      inStreet(false)
 {
     reader.setNamespaceProcessing(false);
 }
 
+//private:
+//hands out the disruptions parsed since the last batch
+void TrafficXmlReader::emitBatch() {
+    if (batch.disruptions.isEmpty() && batch.streets.isEmpty()) return;
+    emit batchParsed(batch);
+    batch = TrafficContainer::Batch();
+}
+
+//returns true if the text of an element is stored, it depends on where the reader is
+bool TrafficXmlReader::isField(const QStringRef& name) const {
+    if (!inDisruption) return false;
+    if (name == "status" || name == "severity" || name == "levelOfInterest" || name == "category" ||
+        name == "subCategory" || name == "startTime" || name == "location" || name == "comments" ||
+        name == "currentUpdate" || name == "remarkTime" || name == "lastModTime") {
+        return true;
+    }
+    if (inPoint && name == "coordinatesLL") return true;
+    return inStreet && (name == "name" || name == "closure" || name == "directions");
+}
+
+//stores the text collected for field
+void TrafficXmlReader::setField() {
+    if (inStreet && field == "name") { currentStreet.name = spaceCommas(text); }
+    else if (inStreet && field == "closure") { currentStreet.closure = (text == "Open") ? "Affected" : text; }
+    else if (inStreet && field == "directions") { currentStreet.directions = text.toLower(); }
+    else if (field == "status") { currentDisruption.status = text; }
+    else if (field == "severity") { currentDisruption.severity = text; }
+    else if (field == "levelOfInterest") { currentDisruption.levelOfInterest = text; }
+    else if (field == "category") { currentDisruption.category = text; }
+    else if (field == "subCategory") { currentDisruption.subCategory = text; }
+    else if (field == "startTime") { currentDisruption.startTime = text; }
+    else if (field == "location") { currentDisruption.location = spaceCommas(text); }
+    else if (field == "comments") { currentDisruption.comments = text; }
+    else if (field == "currentUpdate") { currentDisruption.currentUpdate = text; }
+    else if (field == "remarkTime") { currentDisruption.remarkTime = text; }
+    else if (field == "lastModTime") { currentDisruption.lastModTime = text; }
+    else if (field == "coordinatesLL") { currentDisruption.coordinates = text; }
+}
+
 //public slots:
 //appends to QXmlStreamreader's data
-void TrafficXmlReader::addData(const QByteArray& data) { reader.addData(data);  qDebug() << "+++++++";/*qDebug() << data; */}
+void TrafficXmlReader::addData(const QByteArray& data) { reader.addData(data); }
+
+//to be called when there is no more data, finished() is emitted even if the feed was cut short
+void TrafficXmlReader::endOfData() {
+    if (done) return;
+    if (reader.hasError()) { qDebug() << "Traffic feed ended early:" << reader.errorString(); }
+    emitBatch();
+    done = true;
+    emit finished();
+}
 
 //Function to parse data available, it will emit partFinished() if data is not yet
 //complete, once it is complete finished() signal will be emitted
-//TODO error handling
+//the text of elements is collected token by token rather than by readElementText()
+//so that nothing is lost when an element is split between two parts
 void TrafficXmlReader::parse() {
-    if (!container) return;
+    if (done) return;
     while (!reader.atEnd()) {
         reader.readNext();
-        if (reader.qualifiedName() == "Disruption") {
-            if (reader.isStartElement()) {
+        if (reader.isCharacters()) {
+            if (!field.isEmpty()) { text += reader.text(); }
+        }
+        else if (reader.isStartElement()) {
+            QStringRef name = reader.qualifiedName();
+            if (name == "Disruption") {
                 inDisruption = true;
+                currentDisruption = Disruption();
                 currentID = reader.attributes().value("id").toInt();
             }
-            else if (reader.isEndElement()) {
-                currentDisruption.id = currentID;
-                currentID = 0;
-                container->addDisruption(currentDisruption);
-                inDisruption = false;
-            }
-        }
-        else if (inDisruption && reader.qualifiedName() == "status") {
-            currentDisruption.status = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "severity") {
-            currentDisruption.severity = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "levelOfInterest") {
-            currentDisruption.levelOfInterest = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "category") {
-            currentDisruption.category = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "subCategory") {
-            currentDisruption.subCategory = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "startTime") {
-            currentDisruption.startTime = reader.readElementText();
-        }
-        //replace ',' with ", " if not followed by a whitespace, happends many times due to lousy typing
-        //it is to make WordWrap possible in gui
-        else if (inDisruption && reader.qualifiedName() == "location") {
-            QString location = reader.readElementText();
-            if (location == "") qDebug() << "!!!!!!!!!!!";
-            int i;
-            while ((i = location.indexOf(QRegExp(",[^\\s-]"))) != -1 ) {
-                location = location.insert(++i, " ");
-            }
-            currentDisruption.location = location;
-//            if (location == "") qDebug() << "***this >>>>" << copy; //qDebug() << "!!!!!!!!!!!";
-//            else qDebug() << location;
-        }
-        else if (inDisruption && reader.qualifiedName() == "comments") {
-            currentDisruption.comments = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "currentUpdate") {
-            currentDisruption.currentUpdate = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "remarkTime") {
-            currentDisruption.remarkTime = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "lastModTime") {
-            currentDisruption.lastModTime = reader.readElementText();
-        }
-        else if (inDisruption && reader.qualifiedName() == "Point") {
-            inPoint = true;
-        }
-        else if (inDisruption && inPoint && reader.qualifiedName() == "coordinatesLL") {
-            currentDisruption.coordinates = reader.readElementText();
-        }
-
-        //Streets
-        else if (inDisruption && reader.qualifiedName() == "Street") {
-            if (reader.isStartElement()) {
+            else if (inDisruption && name == "Point") { inPoint = true; }
+            //Streets
+            else if (inDisruption && name == "Street") {
                 inStreet = true;
+                currentStreet = Street();
             }
-            else if (reader.isEndElement()) {
-                container->addStreet(currentID, currentStreet);
+            else if (isField(name)) {
+                field = name.toString();
+                text.clear();
             }
         }
-        else if (inDisruption && inStreet && reader.qualifiedName() == "name") {
-            QString name = reader.readElementText();
-            int i;
-            while ((i = name.indexOf(QRegExp(",[^\\s-]"))) != -1 ) {
-                name = name.insert(++i, " ");
+        else if (reader.isEndElement()) {
+            QStringRef name = reader.qualifiedName();
+            if (!field.isEmpty() && name == field) {
+                setField();
+                field.clear();
             }
-            currentStreet.name = name;
-        }
-        else if (inDisruption && inStreet && reader.qualifiedName() == "closure") {
-            QString closure = reader.readElementText();
-                currentStreet.closure = (closure == "Open") ? "Affected" : closure;
-        }
-        else if (inDisruption && inStreet && reader.qualifiedName() == "directions") {
-            currentStreet.directions = reader.readElementText().toLower();
-        }
-
-        if (reader.hasError()) {
-            if (reader.error() == QXmlStreamReader::PrematureEndOfDocumentError) {
-                emit partFinished();
+            else if (name == "Disruption") {
+                currentDisruption.id = currentID;
+                batch.disruptions << currentDisruption;
+                inDisruption = false;
+                inPoint = false;
+                inStreet = false;
+            }
+            else if (inDisruption && name == "Point") { inPoint = false; }
+            else if (inDisruption && name == "Street") {
+                if (currentID) { batch.streets.insertMulti(currentID, currentStreet); }
+                inStreet = false;
             }
-            else { qDebug() << "An Error has occured while parsing."; }
         }
     }
-    if (!reader.hasError()) {
-        emit finished();
+    if (reader.error() == QXmlStreamReader::PrematureEndOfDocumentError) {
+        //the rest is parsed when it is added
+        emitBatch();
+        emit partFinished();
+        return;
     }
+    if (reader.hasError()) { qDebug() << "An Error has occured while parsing." << reader.errorString(); }
+    emitBatch();
+    done = true;
+    emit finished();
 }
 
 //a slot to be connected when running in a different thread due to how QThread works
@@ -26,34 +26,46 @@ THE SOFTWARE.
 #define TRAFFICXMLREADER_H
 
 #include <QObject>
+#include <QString>
 #include <QXmlStreamReader>
 
 #include "disruption.h"
 #include "street.h"
 #include "trafficcontainer.h"
 
-//This class is responsible of parsing our XML feed
-// and storing the objects extracted in a container to which
-// a handle is provided
+//This class is responsible of parsing our XML feed as it is downloaded,
+// each part of the feed is parsed as soon as it is added and the disruptions
+// found in it are handed out in a batch, text of elements split between
+// parts is collected until the element ends
+// !!! It is meant to run on a thread of its own so it MUST NOT have a parent !!!
 class TrafficXmlReader : public QObject
 {
     Q_OBJECT
 public:
     TrafficXmlReader(QObject* parent = 0);
 private:
-    TrafficContainer* container;
+    TrafficContainer::Batch batch;//parsed since the last batchParsed()
     int currentID;
     Disruption currentDisruption;
     Street currentStreet;
+    bool done;//finished() has been emitted
+    QString field;//name of the element whose text is being collected
     bool inDisruption;
     bool inPoint;
     bool inStreet;
     QXmlStreamReader reader;
+    QString text;//of field so far
+private:
+    void emitBatch();
+    bool isField(const QStringRef& name) const;
+    void setField();
 signals:
+    void batchParsed(const TrafficContainer::Batch&);
     void finished();
     void partFinished();
 public slots:
     void addData(const QByteArray&);
+    void endOfData();
     void parse();
     void parseAvailableData(const QByteArray&);
 };
@@ -24,10 +24,10 @@ THE SOFTWARE.
 
 #include "trafficlogic.h"
 #include <QDebug>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QThread>
 
+#include "network/managedreply.h"
+#include "network/requestmanager.h"
 #include "traffic/disruptionproxymodel.h"
 #include "traffic/trafficcontainer.h"
 #include "traffic/trafficxmlreader.h"
@@ -37,13 +37,15 @@ TrafficLogic::TrafficLogic(QObject *parent) :
     QObject(parent),
     container(new TrafficContainer(this)),
     downloading(false),
-    networkMngr(static_cast<QNetworkAccessManager*>(parent)),
     parsing(false),
     reader(0),
+    replacing(false),
     reply(0),
-    url("http://data.tfl.gov.uk/tfl/syndication/feeds/tims_feed.xml?app_id=663a8a04&app_key=a1f29a8c881ffd777431a7cecf6c2d3b"),
-    workContainer(0)
+    requestManager(static_cast<RequestManager*>(parent)),
+    url("http://data.tfl.gov.uk/tfl/syndication/feeds/tims_feed.xml?app_id=663a8a04&app_key=a1f29a8c881ffd777431a7cecf6c2d3b")
 {
+    //batches are sent from the thread of the parser
+    qRegisterMetaType<TrafficContainer::Batch>("TrafficContainer::Batch");
 }
 
 //private:
@@ -52,35 +54,44 @@ TrafficLogic::TrafficLogic(QObject *parent) :
 //slot that is called when download is finished and no more data to be downloaded
 void TrafficLogic::onAllDataRecieved() {
     downloading = false;
-    QByteArray data = reply->readAll();
-    if (!data.isEmpty()) { parsing = true; }
+    onDataRecieved();
     emit stateChanged();
-    emit dataReady(data);
+    //the parser finishes even if the feed was cut short
+    emit dataEnded();
     reply->deleteLater();
 }
 
+//slot that is called for every batch of disruptions parsed, they are shown while the rest is downloaded
+void TrafficLogic::onBatchParsed(const TrafficContainer::Batch& batch) {
+    if (!container) {
+        qDebug() << "container is nullptr";
+        return;
+    }
+    if (replacing) {
+        container->clear();
+        replacing = false;
+    }
+    container->append(batch);
+}
+
 // slot that is called whenever data is ready to be parsed
 void TrafficLogic::onDataRecieved() {
-    //moved to TrafficLogic::onAllDataRecieved() until I figure out how to fix bug when
-    //certain strings(location) found by parser are empty
-//    parsing = true;
-//    emit stateChanged();
-//    emit dataReady(reply->readAll());
+    QByteArray data = reply->readAll();
+    if (data.isEmpty()) return;
+    if (!parsing) {
+        parsing = true;
+        emit stateChanged();
+    }
+    emit dataReady(data);
 }
 
 //slot to be called upon finishing parsing
 void TrafficLogic::onParsingFinished() {
     parsing = false;
+    //nothing was parsed, the previous data is kept
+    replacing = false;
+    reader = 0;//deleted by itself
     emit stateChanged();
-    //just sanity check neither should be nullptr
-    if (container && workContainer) {
-        container->swap(*(workContainer.data()));
-        workContainer.reset();
-    }
-    else {
-        if (!container) qDebug() << "container is nullptr";
-        if (!workContainer) qDebug() << "workContainer is nullptr";
-    }
 }
 
 //Tfl doesn't set Content-Length in the header so there is no way of knowing what percentage is complete
@@ -101,12 +112,13 @@ bool TrafficLogic::isParsing() { return parsing; }
 
 //to be called by GUI to request new data, not to be used until parsing is finished
 void TrafficLogic::refresh() {
-    if (networkMngr && !parsing) {
-        workContainer.reset(new TrafficContainer(this));
-        reader = new TrafficXmlReader(workContainer.data());
+    if (requestManager && !parsing && !downloading) {
+        replacing = true;
+        reader = new TrafficXmlReader();
         QThread* parserThread = new QThread();
         reader->moveToThread(parserThread);
 
+        connect(reader, SIGNAL(batchParsed(TrafficContainer::Batch)), this, SLOT(onBatchParsed(TrafficContainer::Batch)) );
         connect(reader, SIGNAL(finished()), this, SLOT(onParsingFinished()) );
         connect(reader, SIGNAL(finished()), parserThread, SLOT(quit()) );
 
@@ -115,7 +127,7 @@ void TrafficLogic::refresh() {
 
         parserThread->start();
 
-        reply = networkMngr->get(QNetworkRequest(url));
+        reply = requestManager->get(url, RequestManager::Normal, "traffic");
         downloading = true;
         emit stateChanged();
 
@@ -123,5 +135,6 @@ void TrafficLogic::refresh() {
         connect(reply, SIGNAL(downloadProgress(qint64,qint64)),this, SLOT(progressSlot(qint64,qint64)) );
         connect(reply, SIGNAL(readyRead()), this, SLOT(onDataRecieved()) );
         connect(this, SIGNAL(dataReady(QByteArray)), reader, SLOT(parseAvailableData(QByteArray)) );
+        connect(this, SIGNAL(dataEnded()), reader, SLOT(endOfData()) );
     }
 }
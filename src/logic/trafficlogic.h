@@ -31,15 +31,15 @@ THE SOFTWARE.
 #include "traffic/trafficcontainer.h"
 
 class DisruptionProxyModel;
-class QNetworkAccessManager;
-class QNetworkReply;
+class ManagedReply;
+class RequestManager;
 class StreetModel;
 class TrafficXmlReader;
 
 
 //This class is responsible in coordinating the efforts required to
 //aquire, store and prepare data for GUI.
-// !!! Parent MUST be a QNetworkAccessManager or a nullptr !!!
+// !!! Parent MUST be a RequestManager or a nullptr !!!
 class TrafficLogic : public QObject
 {
     Q_OBJECT
@@ -48,20 +48,22 @@ public:
 private:
     TrafficContainer* container;
     bool downloading;
-    QNetworkAccessManager* networkMngr;
     bool parsing;
     TrafficXmlReader* reader;
-    QNetworkReply* reply;
+    bool replacing;//data of the previous refresh is shown until the first batch of the new one is parsed
+    ManagedReply* reply;
+    RequestManager* requestManager;
     QUrl url;
-    QScopedPointer<TrafficContainer> workContainer;
 
 private:
 signals:
+    void dataEnded();
     void dataReady(QByteArray);
     void downloadProgress(qint64 value);
     void stateChanged();
 private slots:
     void onAllDataRecieved();
+    void onBatchParsed(const TrafficContainer::Batch&);
     void onDataRecieved();
     void onParsingFinished();
     void progressSlot(qint64,qint64);
@@ -0,0 +1,29 @@
+# Standalone benchmark of importing stations.csv, it is not part of the app.
+# Build with: qmake && make && ./importbench [rows] [runs]
+TARGET = importbench
+
+CONFIG += console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -std=c++0x
+
+QT -= gui
+QT += sql
+
+INCLUDEPATH += ../../src/logic/database
+
+SOURCES += main.cpp \
+    ../../src/logic/arrivals/vehicle.cpp \
+    ../../src/logic/database/databaseexecutor.cpp \
+    ../../src/logic/database/statementcache.cpp \
+    ../../src/logic/database/stopimporter.cpp \
+    ../../src/logic/database/stopindex.cpp \
+    ../../src/logic/database/stopnameindex.cpp \
+    ../../src/logic/database/stoprecord.cpp
+
+HEADERS += ../../src/logic/database/databaseexecutor.h \
+    ../../src/logic/database/statementcache.h \
+    ../../src/logic/database/stopimporter.h \
+    ../../src/logic/database/stopindex.h \
+    ../../src/logic/database/stopnameindex.h \
+    ../../src/logic/database/stoprecord.h
@@ -0,0 +1,120 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVariant>
+#include <QtGlobal>
+#include "databaseexecutor.h"
+
+//writes a csv in the layout of stations.csv and imports it into an empty db through DatabaseExecutor
+//the same way the app does, then prints how many rows per second were written
+namespace {
+    const int defaultRows = 20000;
+    const int defaultRuns = 5;
+
+    double random(double from, double to) { return from + (to - from) * qrand() / RAND_MAX; }
+
+    //returns false if the file couldn't be written
+    bool writeCsv(const QString& path, int rows) {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) { return false; }
+        QTextStream out(&file);
+        out << "name;code;type;towards;latitude;longitude;stoppointindicator;favorite;rank\n";
+        for (int row = 0; row != rows; ++row) {
+            out << "Station " << row << ";S" << row << ";2;;" << QString::number(random(51.28, 51.69), 'f', 12) << ";"
+                << QString::number(random(-0.51, 0.33), 'f', 12) << ";;0;\n";
+        }
+        return true;
+    }
+
+    int countRows(const QString& path) {
+        int count = -1;
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench");
+            db.setDatabaseName(path);
+            QSqlQuery query(db);
+            if (db.open() && query.exec("SELECT COUNT(*) FROM stopstable") && query.next()) { count = query.value(0).toInt(); }
+            query.finish();
+            db.close();
+        }
+        QSqlDatabase::removeDatabase("bench");
+        return count;
+    }
+}//end of unnamed namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int rows = args.size() > 1 ? args.at(1).toInt() : defaultRows;
+    int runs = args.size() > 2 ? args.at(2).toInt() : defaultRuns;
+    QTextStream out(stdout);
+    QTemporaryDir dir;
+    QString csv = dir.path() + "/stations.csv";
+    qsrand(1);
+    if (!dir.isValid() || !writeCsv(csv, rows)) {
+        out << "Couldn't write " << csv << endl;
+        return 1;
+    }
+    double total = 0;
+    for (int run = 0; run != runs; ++run) {
+        QString path = dir.path() + QString("/run%1.sqlite").arg(run);
+        bool ok = false;
+        qint64 elapsed = 0;
+        {
+            DatabaseExecutor executor(path);
+            QElapsedTimer timer;
+            //stops are indexed again after the signal, that is not part of the import
+            QObject::connect(&executor, &DatabaseExecutor::stationsImported, [&ok, &elapsed, &timer](bool result) {
+                ok = result;
+                elapsed = qMax(timer.elapsed(), qint64(1));
+            });
+            //creates the schema the app has
+            if (!executor.open()) {
+                out << "Couldn't create " << path << endl;
+                return 1;
+            }
+            executor.importStations(csv);
+            timer.start();
+            //the queued invocation is never delivered since there is no event loop, the jobs are run right here
+            executor.runJobs();
+        }
+        int imported = countRows(path);
+        if (!ok || imported != rows) {
+            out << "Run " << run + 1 << " failed, " << imported << " of " << rows << " rows imported" << endl;
+            return 1;
+        }
+        double rate = rows * 1000.0 / elapsed;
+        total += rate;
+        out << "Run " << run + 1 << ": " << rows << " rows in " << elapsed << " ms, " << qRound(rate) << " rows/s" << endl;
+    }
+    out << "Average: " << qRound(total / runs) << " rows/s" << endl;
+    return 0;
+}
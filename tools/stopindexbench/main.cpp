@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2014 Krisztian Olah
+
+  email: fasza2mobile@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QtGlobal>
+#include "stopindex.h"
+
+//fills a StopIndex with stops spread over Greater London like stops.csv
+//and prints how long nearest-stop and bounding box queries take on average
+namespace {
+    const int stopCount = 20000;
+    const int queryCount = 1000;
+    const double south = 51.28;
+    const double west = -0.51;
+    const double north = 51.69;
+    const double east = 0.33;
+
+    double random(double from, double to) { return from + (to - from) * qrand() / RAND_MAX; }
+
+    //runs query for queryCount points from pointAt and returns the average time of one in microseconds
+    template<class Query, class Point>
+    double measure(const StopIndex& index, Query query, Point pointAt) {
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i != queryCount; ++i) {
+            double latitude, longitude;
+            pointAt(latitude, longitude);
+            query(index, latitude, longitude);
+        }
+        return timer.nsecsElapsed() / 1000.0 / queryCount;
+    }
+}//end of unnamed namespace
+
+int main() {
+    qsrand(1);
+    StopIndex index;
+    for (int i = 0; i != stopCount; ++i) {
+        StopIndex::Entry entry;
+        entry.code = QString::number(10000 + i);
+        entry.type = i % 10 ? 1 : 2;
+        entry.latitude = random(south, north);
+        entry.longitude = random(west, east);
+        index.insert(entry);
+    }
+    QTextStream out(stdout);
+    out << index.size() << " stops indexed, average of " << queryCount << " queries in microseconds" << endl;
+
+    auto inLondon = [](double& latitude, double& longitude) {
+        latitude = random(south, north);
+        longitude = random(west, east);
+    };
+    //the worst case, the whole extent of stops is walked
+    auto farAway = [](double& latitude, double& longitude) {
+        latitude = random(-60, 60);
+        longitude = random(-180, 180);
+    };
+    auto nearest = [](const StopIndex& index, double latitude, double longitude) {
+        return index.nearest(latitude, longitude, 10).size();
+    };
+    auto nearestOfType = [](const StopIndex& index, double latitude, double longitude) {
+        return index.nearest(latitude, longitude, 10, 2).size();
+    };
+    //about 1km x 1km
+    auto within = [](const StopIndex& index, double latitude, double longitude) {
+        return index.within(latitude - 0.0045, longitude - 0.0072, latitude + 0.0045, longitude + 0.0072).size();
+    };
+    out << "nearest 10:              " << measure(index, nearest, inLondon) << endl;
+    out << "nearest 10 of a type:    " << measure(index, nearestOfType, inLondon) << endl;
+    out << "nearest 10 far away:     " << measure(index, nearest, farAway) << endl;
+    out << "within 1km x 1km:        " << measure(index, within, inLondon) << endl;
+    return 0;
+}
@@ -0,0 +1,17 @@
+# Standalone benchmark of StopIndex, it is not part of the app.
+# Build with: qmake && make && ./stopindexbench
+TARGET = stopindexbench
+
+CONFIG += console
+CONFIG -= app_bundle
+
+QMAKE_CXXFLAGS += -std=c++0x
+
+QT -= gui
+
+INCLUDEPATH += ../../src/logic/database
+
+SOURCES += main.cpp \
+    ../../src/logic/database/stopindex.cpp
+
+HEADERS += ../../src/logic/database/stopindex.h
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+# Copyright (C) 2026 London Sail contributors
+# Released under the MIT license, see LICENSE in the root of the repository.
+"""Stands in for the TfL URA server so that streaming and polling can be tried without network.
+
+The app is pointed at it by adding the following to its settings file
+(~/.config/harbour-london-sail/harbour-london-sail.conf):
+
+    [ura]
+    server=http://<address of this machine>:8000/interfaces/ura/
+    streaming=true
+
+Every line of the fixture is a prediction unless its "record" is "message", a flexible message
+of a stop. Like the real server, predictions are only sent if ReturnList asks for prediction fields,
+messages only if it asks for message fields, and if it asks for stop fields only, every stop of the
+fixture is sent once as a stop array.
+
+instant_V1 answers with the records of the fixture that are known at the start (at = 0),
+stream_V1 pushes every record of the fixture once its time (at, in seconds) has come.
+EstimatedTime, ExpireTime and StartTime of the fixture are seconds from the start of the replay
+and are sent as msec from Epoch like the real server does. Only the fields asked for in ReturnList
+are sent, in the order of the Bus arrivals API documentation, and only the stops or vehicle asked for.
+
+    ./urareplay.py [--port 8000] [--speed 1.0] [--loop] [fixture.jsonl]
+"""
+
+import argparse
+import json
+import os
+import time
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from socketserver import ThreadingMixIn
+from urllib.parse import parse_qs, urlparse
+
+# the order in which the server sends the fields of a prediction, see urareader.cpp
+STOP_ORDER = ["StopPointName", "StopID", "StopCode1", "StopCode2", "StopPointType", "Towards",
+              "Bearing", "StopPointIndicator", "StopPointState", "Latitude", "Longitude"]
+PREDICTION_ORDER = ["VisitNumber", "LineID", "LineName", "DirectionID", "DestinationText",
+                    "DestinationName", "VehicleID", "TripID", "RegistrationNumber",
+                    "EstimatedTime", "ExpireTime"]
+MESSAGE_ORDER = ["MessageUUID", "MessageType", "MessagePriority", "MessageText", "StartTime", "ExpireTime"]
+STOP_RECORD = 0
+PREDICTION_RECORD = 1
+MESSAGE_RECORD = 2
+VERSION_RECORD = 4
+TIMES = ("EstimatedTime", "ExpireTime", "StartTime")
+
+
+class Replay:
+    def __init__(self, path, speed, loop):
+        with open(path) as fixture:
+            self.records = [json.loads(line) for line in fixture if line.strip()]
+        self.records.sort(key=lambda record: record.get("at", 0))
+        self.speed = speed
+        self.loop = loop
+
+    def matches(self, record, query):
+        stops = query.get("StopCode1")
+        if stops and record.get("StopCode1") not in stops[0].split(","):
+            return False
+        vehicles = query.get("RegistrationNumber")
+        if vehicles and record.get("RegistrationNumber") not in vehicles[0].split(","):
+            return False
+        name = query.get("StopPointName")
+        if name and name[0].lower() not in (record.get("StopPointName") or "").lower():
+            return False
+        return True
+
+    def stops(self, query, fields):
+        """Returns a stop array for every stop of the fixture that matches query, each stop once."""
+        lines = []
+        seen = set()
+        for record in self.records:
+            code = record.get("StopCode1")
+            if code in seen or not self.matches(record, query):
+                continue
+            seen.add(code)
+            lines.append(self.line(STOP_RECORD, record, fields, 0))
+        return lines
+
+    def record(self, record, fields, start):
+        """Returns the array of a prediction or a message or None if ReturnList doesn't ask for its kind."""
+        if record.get("record") == "message":
+            kind = MESSAGE_RECORD
+            order = MESSAGE_ORDER
+        else:
+            kind = PREDICTION_RECORD
+            order = PREDICTION_ORDER
+        if not any(name in fields for name in order):
+            return None
+        return self.line(kind, record, fields, start)
+
+    def line(self, kind, record, fields, start):
+        order = STOP_ORDER
+        if kind == PREDICTION_RECORD:
+            order = STOP_ORDER + PREDICTION_ORDER
+        elif kind == MESSAGE_RECORD:
+            order = STOP_ORDER + MESSAGE_ORDER
+        array = [kind]
+        for name in order:
+            if name not in fields:
+                continue
+            value = record.get(name)
+            if name in TIMES and value is not None:
+                value = int((start + value / self.speed) * 1000)
+            array.append(value)
+        return json.dumps(array) + "\r\n"
+
+    def version(self):
+        return json.dumps([VERSION_RECORD, "1.0", int(time.time() * 1000)]) + "\r\n"
+
+
+def stops_only(fields):
+    """Returns true if ReturnList asks for stop fields only, the server sends stop arrays then."""
+    return not any(name in fields for name in PREDICTION_ORDER + MESSAGE_ORDER)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.0"
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        query = parse_qs(url.query)
+        fields = query.get("ReturnList", [""])[0].split(",")
+        if url.path.endswith("/instant_V1"):
+            self.instant(query, fields)
+        elif url.path.endswith("/stream_V1"):
+            self.stream(query, fields)
+        else:
+            self.send_error(404)
+
+    def begin(self):
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.end_headers()
+
+    def instant(self, query, fields):
+        replay = self.server.replay
+        start = time.time()
+        body = replay.version()
+        if stops_only(fields):
+            body += "".join(replay.stops(query, fields))
+        for record in replay.records:
+            if record.get("at", 0) > 0 or stops_only(fields) or not replay.matches(record, query):
+                continue
+            line = replay.record(record, fields, start)
+            if line:
+                body += line
+        self.begin()
+        self.wfile.write(body.encode())
+
+    def stream(self, query, fields):
+        replay = self.server.replay
+        self.begin()
+        try:
+            self.wfile.write(replay.version().encode())
+            if stops_only(fields):
+                self.wfile.write("".join(replay.stops(query, fields)).encode())
+                return
+            self.wfile.flush()
+            while True:
+                start = time.time()
+                for record in replay.records:
+                    delay = start + record.get("at", 0) / replay.speed - time.time()
+                    if delay > 0:
+                        time.sleep(delay)
+                    line = replay.record(record, fields, start) if replay.matches(record, query) else None
+                    if line:
+                        self.wfile.write(line.encode())
+                        self.wfile.flush()
+                if not replay.loop:
+                    return
+        except (BrokenPipeError, ConnectionResetError):
+            return
+
+
+class Server(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Replays URA predictions to the app.")
+    parser.add_argument("fixture", nargs="?", default=os.path.join(here, "oxfordcircus.jsonl"))
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--speed", type=float, default=1.0, help="2 replays twice as fast")
+    parser.add_argument("--loop", action="store_true", help="start the stream again when it ran out")
+    args = parser.parse_args()
+    server = Server(("", args.port), Handler)
+    server.replay = Replay(args.fixture, args.speed, args.loop)
+    print("Replaying %d records of %s on port %d" % (len(server.replay.records), args.fixture, args.port))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()